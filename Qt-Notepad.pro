@@ -1,6 +1,6 @@
 QT       += core gui
 
-greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets concurrent network
 
 CONFIG += c++11
 
@@ -16,16 +16,57 @@ DEFINES += QT_DEPRECATED_WARNINGS
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    batchprocessor.cpp \
+    dirtytracker.cpp \
+    documenttab.cpp \
+    encodingdetector.cpp \
+    fileloader.cpp \
+    filemonitor.cpp \
+    filesaver.cpp \
     finddialog.cpp \
+    gotodialog.cpp \
+    largefileview.cpp \
+    layoutscheduler.cpp \
+    lineending.cpp \
+    lineindex.cpp \
     main.cpp \
-    mainwindow.cpp
+    mainwindow.cpp \
+    piecetable.cpp \
+    searchengine.cpp \
+    sessionjournal.cpp \
+    settingscache.cpp \
+    singleinstance.cpp \
+    startuptrace.cpp \
+    textbuffer.cpp \
+    textmatcher.cpp
 
 HEADERS += \
+    batchprocessor.h \
+    dirtytracker.h \
+    documenttab.h \
+    encodingdetector.h \
+    fileloader.h \
+    filemonitor.h \
+    filesaver.h \
     finddialog.h \
-    mainwindow.h
+    gotodialog.h \
+    largefileview.h \
+    layoutscheduler.h \
+    lineending.h \
+    lineindex.h \
+    mainwindow.h \
+    piecetable.h \
+    searchengine.h \
+    sessionjournal.h \
+    settingscache.h \
+    singleinstance.h \
+    startuptrace.h \
+    textbuffer.h \
+    textmatcher.h
 
 FORMS += \
     finddialog.ui \
+    gotodialog.ui \
     mainwindow.ui
 
 # Default rules for deployment.
@@ -0,0 +1,279 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QThreadPool>
+#include <QSaveFile>
+#include <QTextCodec>
+#include <QFileInfo>
+#include <QDir>
+#include <QScopedPointer>
+#include <QtConcurrent/QtConcurrent>
+#include <QDebug>
+#include <cstdio>
+#include "batchprocessor.h"
+#include "fileloader.h"
+#include "searchengine.h"
+#include "encodingdetector.h"
+
+bool BatchProcessor::isRequested(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (qstrncmp(argv[i], "--find", 6) == 0 || qstrncmp(argv[i], "--replace", 9) == 0
+                || qstrncmp(argv[i], "--to-encoding", 13) == 0)
+            return true;
+    }
+    return false;
+}
+
+/**
+ * @brief BatchProcessor::run
+ * 解析参数后把每个文件交给线程池，结果按命令行中的顺序输出
+ * @return 全部成功时为 0
+ */
+int BatchProcessor::run(const QStringList &args)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("批量查找、替换和转换编码");
+    parser.addHelpOption();
+    parser.addOptions({
+        {"find", "要查找的内容", "文本"},
+        {"replace", "替换为，正则表达式中可用 \\1、$1 引用捕获组", "文本"},
+        {"regex", "使用正则表达式"},
+        {"case-sensitive", "区分大小写"},
+        {"whole-word", "全字匹配"},
+        {"to-encoding", "转换为指定编码", "编码"},
+        {"bom", "转换编码时写入 BOM"},
+        {"jobs", "同时处理的文件数", "N", QString::number(QThread::idealThreadCount())},
+        {"dry-run", "只统计，不写入文件"},
+    });
+    parser.addPositionalArgument("files", "文件或通配符", "文件...");
+    parser.process(args);
+
+    Options options;
+    options.find = parser.value("find");
+    options.replace = parser.value("replace");
+    options.replacing = parser.isSet("replace");
+    options.regex = parser.isSet("regex");
+    options.caseSensitive = parser.isSet("case-sensitive");
+    options.wholeWord = parser.isSet("whole-word");
+    options.toCodec = parser.value("to-encoding").toLatin1();
+    options.bom = parser.isSet("bom");
+    options.dryRun = parser.isSet("dry-run");
+
+    if (options.replacing && options.find.isEmpty())
+    {
+        qWarning() << "替换时需要用 --find 指定查找内容";
+        return 2;
+    }
+    if (!options.toCodec.isEmpty() && !QTextCodec::codecForName(options.toCodec))
+    {
+        qWarning() << "不支持的编码：" << options.toCodec;
+        return 2;
+    }
+
+    BatchProcessor processor(options);
+    if (options.regex && !processor.re.isValid())
+    {
+        qWarning() << "无效的正则表达式：" << processor.re.errorString();
+        return 2;
+    }
+
+    const QStringList paths = expand(parser.positionalArguments());
+    if (paths.isEmpty())
+    {
+        qWarning() << "没有要处理的文件";
+        return 2;
+    }
+
+    // 每个文件只占一块解码缓冲，线程数就是内存占用的上限
+    QThreadPool pool;
+    pool.setMaxThreadCount(qMax(1, parser.value("jobs").toInt()));
+    QList<QFuture<Result>> futures;
+    for (const QString& path: paths)
+        futures.append(QtConcurrent::run(&pool, [&processor, path]{
+            return processor.process(path);
+        }));
+
+    int failed = 0;
+    for (QFuture<Result>& future: futures)
+    {
+        const Result result = future.result();
+        if (!result.error.isEmpty())
+        {
+            failed++;
+            std::fputs(qPrintable(QString("%1：%2\n").arg(result.path, result.error)), stderr);
+            continue;
+        }
+        QString line = QString("%1：%2 处匹配").arg(result.path).arg(result.matches);
+        if (!options.toCodec.isEmpty())
+            line += "，编码 " + QString(options.toCodec);
+        std::fputs(qPrintable(line + '\n'), stdout);
+    }
+    std::fflush(stdout);
+    return failed ? 1 : 0;
+}
+
+BatchProcessor::BatchProcessor(const Options &options) : options(options)
+{
+    if (options.find.isEmpty())
+        return ;
+    if (options.regex)
+        re = SearchEngine::compile(options.find, options.caseSensitive, options.wholeWord);
+    else
+        matcher = TextMatcher(options.find, options.caseSensitive, options.wholeWord);
+}
+
+/**
+ * @brief BatchProcessor::process
+ * 逐块解码，每块只处理到最后一个换行符，剩下的半行并入下一块，
+ * 处理后立即编码写入临时文件，没有改动时放弃写入，原文件保持不变
+ */
+BatchProcessor::Result BatchProcessor::process(const QString &path) const
+{
+    Result result;
+    result.path = path;
+
+    FileLoader loader;
+    if (!loader.open(path))
+    {
+        result.error = "无法打开文件";
+        return result;
+    }
+
+    const QByteArray codec = options.toCodec.isEmpty() ? loader.codecName() : options.toCodec;
+    const bool bom = options.toCodec.isEmpty() ? loader.hasBom() || options.bom : options.bom;
+    QTextCodec* textCodec = QTextCodec::codecForName(codec);
+    if (!textCodec)
+    {
+        result.error = "不支持的编码：" + QString(codec);
+        return result;
+    }
+
+    const bool writing = !options.dryRun && (options.replacing || !options.toCodec.isEmpty());
+    QSaveFile file(path);
+    if (writing)
+    {
+        if (!file.open(QIODevice::WriteOnly))
+        {
+            result.error = file.errorString();
+            return result;
+        }
+        if (bom)
+            file.write(EncodingDetector::byteOrderMark(codec));
+    }
+
+    QScopedPointer<QTextEncoder> encoder(textCodec->makeEncoder(QTextCodec::IgnoreHeader));
+    QString carry;
+    while (!loader.atEnd())
+    {
+        QString text = carry + loader.readChunk();
+        carry.clear();
+        if (!loader.atEnd())
+        {
+            const int cut = qMax(text.lastIndexOf('\n'), text.lastIndexOf('\r'));
+            carry = text.mid(cut + 1);
+            text.truncate(cut + 1);
+            if (text.isEmpty())
+                continue;
+        }
+
+        text = replaceIn(text, &result.matches);
+        if (!writing)
+            continue;
+        const QByteArray bytes = encoder->fromUnicode(text);
+        if (encoder->hasFailure())
+            result.error = "部分字符无法用 " + QString(codec) + " 编码表示";
+        else if (file.write(bytes) < 0)
+            result.error = file.errorString();
+        if (!result.error.isEmpty())
+        {
+            file.cancelWriting();
+            return result;
+        }
+    }
+
+    if (!writing)
+        return result;
+    if (result.matches == 0 && options.toCodec.isEmpty())
+    {
+        file.cancelWriting();
+        return result;
+    }
+    loader.close(); // 先解除映射，否则有的平台上不能替换原文件
+    if (!file.commit())
+        result.error = file.errorString();
+    return result;
+}
+
+/**
+ * @brief BatchProcessor::replaceIn
+ * 与编辑器的全部替换一致：匹配互不重叠，跳过空匹配，替换内容按原文插入
+ * @return 替换后的文本；不替换时原样返回
+ */
+QString BatchProcessor::replaceIn(const QString &text, int *matches) const
+{
+    if (options.find.isEmpty())
+        return text;
+
+    QString out;
+    int last = 0;
+    if (options.regex)
+    {
+        QRegularExpressionMatchIterator it = re.globalMatch(text);
+        while (it.hasNext())
+        {
+            const QRegularExpressionMatch m = it.next();
+            if (m.capturedLength() == 0)
+                continue;
+            ++*matches;
+            if (options.replacing)
+            {
+                out.append(text.midRef(last, m.capturedStart() - last));
+                out.append(SearchEngine::expandReplacement(options.replace, m)); // 展开 \1、$1 等捕获组
+                last = m.capturedEnd();
+            }
+        }
+    }
+    else
+    {
+        int pos = 0;
+        while ((pos = matcher.indexIn(text.constData(), text.length(), pos)) >= 0)
+        {
+            ++*matches;
+            if (options.replacing)
+            {
+                out.append(text.midRef(last, pos - last));
+                out.append(options.replace);
+                last = pos + matcher.length();
+            }
+            pos += matcher.length();
+        }
+    }
+
+    if (!options.replacing || last == 0)
+        return text;
+    out.append(text.midRef(last));
+    return out;
+}
+
+/**
+ * @brief BatchProcessor::expand
+ * 展开含 * ? [ 的文件名（Windows 的命令行不会替我们展开）
+ */
+QStringList BatchProcessor::expand(const QStringList &patterns)
+{
+    QStringList paths;
+    for (const QString& pattern: patterns)
+    {
+        if (!pattern.contains(QRegularExpression("[*?\\[]")))
+        {
+            paths << pattern;
+            continue;
+        }
+        const QFileInfo info(pattern);
+        const QDir dir(info.path());
+        for (const QString& name: dir.entryList(QStringList(info.fileName()), QDir::Files, QDir::Name))
+            paths << dir.filePath(name);
+    }
+    return paths;
+}
@@ -0,0 +1,54 @@
+#ifndef BATCHPROCESSOR_H
+#define BATCHPROCESSOR_H
+
+#include <QStringList>
+#include <QRegularExpression>
+#include "textmatcher.h"
+
+/**
+ * 命令行批处理
+ * notepad --find=文本 [--replace=文本] [--regex] [--case-sensitive] [--whole-word]
+ *         [--to-encoding=编码] [--bom] [--jobs=N] [--dry-run] 文件或通配符...
+ * 不创建窗口，与编辑器共用编码检测、分块解码和查找匹配的代码，
+ * 多个文件由有上限的线程池并行处理，每个文件逐块读取、逐块写出
+ */
+class BatchProcessor
+{
+public:
+    static bool isRequested(int argc, char* argv[]);
+    static int run(const QStringList& args);
+
+private:
+    struct Options
+    {
+        QString find;
+        QString replace;
+        bool replacing = false;
+        bool regex = false;
+        bool caseSensitive = false;
+        bool wholeWord = false;
+        QByteArray toCodec;
+        bool bom = false;
+        bool dryRun = false;
+    };
+
+    struct Result
+    {
+        QString path;
+        int matches = 0;
+        QString error;
+    };
+
+    explicit BatchProcessor(const Options& options);
+
+    Result process(const QString& path) const;
+    QString replaceIn(const QString& text, int* matches) const;
+    static QStringList expand(const QStringList& patterns);
+
+private:
+    Options options;
+    TextMatcher matcher;
+    QRegularExpression re;
+};
+
+#endif // BATCHPROCESSOR_H
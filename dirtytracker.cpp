@@ -0,0 +1,125 @@
+#include <QTextDocument>
+#include <QTextBlock>
+#include "dirtytracker.h"
+#include "piecetable.h"
+
+// 超过这个字符数就不再做哈希比较，避免空闲时卡住界面
+static const int HASH_CHECK_LIMIT = 16 * 1024 * 1024;
+static const int HASH_CHUNK_SIZE = 1024 * 1024; // textHash() 每次从片段表取出的字符数
+
+DirtyTracker::DirtyTracker(QTextDocument *doc, QObject *parent)
+    : QObject(parent), doc(doc)
+{
+    hashTimer.setSingleShot(true);
+    hashTimer.setInterval(500);
+    connect(&hashTimer, &QTimer::timeout, this, &DirtyTracker::verifyByHash);
+    connect(doc, &QTextDocument::contentsChange, this, &DirtyTracker::onContentsChange);
+}
+
+bool DirtyTracker::isModified() const
+{
+    return doc->isModified();
+}
+
+/**
+ * @brief DirtyTracker::snapshot
+ * 记录当前内容的特征，用于后台保存完成后标记；
+ * withHash 为 false 时不遍历文档，由保存线程用 textHash() 补上哈希
+ */
+DirtyTracker::Snapshot DirtyTracker::snapshot(bool withHash) const
+{
+    Snapshot s;
+    s.revision = doc->revision();
+    s.length = doc->characterCount();
+    s.hashed = withHash && s.length <= HASH_CHECK_LIMIT;
+    s.hash = s.hashed ? documentHash() : 0;
+    return s;
+}
+
+/**
+ * @brief DirtyTracker::markSaved
+ * 打开或保存后调用，记录当前内容为未修改状态
+ */
+void DirtyTracker::markSaved()
+{
+    markSaved(snapshot());
+}
+
+/**
+ * @brief DirtyTracker::markSaved
+ * 保存的是 saved 时刻的内容；之后又有编辑的话仍然是已修改，交给哈希比较
+ */
+void DirtyTracker::markSaved(const Snapshot &saved)
+{
+    hashTimer.stop();
+    savedLength = saved.length;
+    savedHash = saved.hash;
+    savedHashed = saved.hashed && savedLength <= HASH_CHECK_LIMIT;
+    if (doc->revision() == saved.revision)
+        doc->setModified(false);
+    else if (savedHashed && doc->characterCount() == savedLength)
+        hashTimer.start();
+}
+
+void DirtyTracker::onContentsChange(int, int charsRemoved, int charsAdded)
+{
+    if (charsRemoved == 0 && charsAdded == 0)
+        return ;
+
+    // 只有长度回到保存时的长度才可能是“改回原样”
+    if (doc->isModified() && savedHashed && doc->characterCount() == savedLength)
+        hashTimer.start();
+    else
+        hashTimer.stop();
+}
+
+void DirtyTracker::verifyByHash()
+{
+    if (!doc->isModified() || !savedHashed || doc->characterCount() != savedLength)
+        return ;
+
+    if (documentHash() == savedHash)
+        doc->setModified(false); // 撤销栈当前位置作为新的 clean 位置
+}
+
+uint DirtyTracker::documentHash() const
+{
+    uint h = 0;
+    for (QTextBlock block = doc->begin(); block.isValid(); block = block.next())
+        h = qHash(block.text(), h);
+    return h;
+}
+
+/**
+ * @brief DirtyTracker::textHash
+ * 与 documentHash() 相同的哈希，按 \n 分段，可在后台线程对快照计算
+ */
+uint DirtyTracker::textHash(const PieceTable &text)
+{
+    if (text.length() + 1 > HASH_CHECK_LIMIT) // characterCount() 多一个结尾段落符
+        return 0;
+
+    uint h = 0;
+    QString line; // 跨块的一段
+    for (int i = 0; i < text.length(); i += HASH_CHUNK_SIZE)
+    {
+        const QString chunk = text.mid(i, HASH_CHUNK_SIZE);
+        int start = 0;
+        for (int end = chunk.indexOf('\n'); end >= 0; end = chunk.indexOf('\n', start))
+        {
+            if (line.isEmpty())
+            {
+                h = qHash(chunk.midRef(start, end - start), h);
+            }
+            else
+            {
+                line += chunk.midRef(start, end - start);
+                h = qHash(line, h);
+                line.clear();
+            }
+            start = end + 1;
+        }
+        line += chunk.midRef(start);
+    }
+    return qHash(line, h);
+}
@@ -0,0 +1,52 @@
+#ifndef DIRTYTRACKER_H
+#define DIRTYTRACKER_H
+
+#include <QObject>
+#include <QTimer>
+
+class QTextDocument;
+class PieceTable;
+
+/**
+ * 文档修改状态跟踪
+ * 平时直接使用 QTextDocument 自带的 modified 标记（撤销栈的 clean 位置），O(1)
+ * 手动输入又删除回原样时撤销栈不会回到 clean，
+ * 此时若长度与保存时相同，空闲时再比较一次分块哈希
+ */
+class DirtyTracker : public QObject
+{
+    Q_OBJECT
+public:
+    explicit DirtyTracker(QTextDocument* doc, QObject *parent = nullptr);
+
+    struct Snapshot
+    {
+        int revision = -1;
+        int length = 0;
+        uint hash = 0;
+        bool hashed = false; // 没有哈希时只按版本判断，不做“改回原样”的比较
+    };
+
+    bool isModified() const;
+    Snapshot snapshot(bool withHash = true) const;
+    void markSaved();
+    void markSaved(const Snapshot& saved);
+
+    static uint textHash(const PieceTable& text);
+
+private slots:
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
+    void verifyByHash();
+
+private:
+    uint documentHash() const;
+
+private:
+    QTextDocument* doc;
+    int savedLength = 0;
+    uint savedHash = 0;
+    bool savedHashed = false;
+    QTimer hashTimer;
+};
+
+#endif // DIRTYTRACKER_H
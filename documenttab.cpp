@@ -0,0 +1,87 @@
+#include <QVBoxLayout>
+#include "documenttab.h"
+
+DocumentTab::DocumentTab(QWidget *parent) : QWidget(parent)
+{
+    editor = new QPlainTextEdit(this);
+    editor->setContextMenuPolicy(Qt::CustomContextMenu);
+    editor->setStyleSheet("QPlainTextEdit\n{\n\tborder: none;\n}");
+    editor->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOn);
+
+    largeFileView = new LargeFileView(this);
+    largeFileView->hide();
+
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    layout->setSpacing(0);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addWidget(editor);
+    layout->addWidget(largeFileView);
+
+    QTextDocument* doc = editor->document();
+    textBuffer = new TextBuffer(doc, this); // 查找引擎跟随它，先于查找引擎创建
+    dirtyTracker = new DirtyTracker(doc, this);
+    journal = new SessionJournal(doc, this);
+    fileSaver = new FileSaver(this);
+    fileLoader = new FileLoader(this);
+    fileMonitor = new FileMonitor(this);
+    layoutScheduler = new LayoutScheduler(editor, this);
+    searchEngine = new SearchEngine(textBuffer, this);
+}
+
+DocumentTab::~DocumentTab()
+{
+    // 关闭标签页前主窗口已经等待保存完成并决定了恢复日志的去留
+    if (loading)
+        fileLoader->cancel();
+}
+
+bool DocumentTab::isModified() const
+{
+    return dirtyTracker->isModified();
+}
+
+/**
+ * @brief DocumentTab::isBlank
+ * 无标题、未修改的空文档，打开文件时直接复用这个标签页
+ */
+bool DocumentTab::isBlank() const
+{
+    return filePath.isEmpty() && !loading && !largeFileMode && !isModified()
+            && editor->document()->isEmpty();
+}
+
+/**
+ * @brief DocumentTab::setLargeFileMode
+ * 切换超大文件只读查看模式，此时不能编辑和保存
+ */
+void DocumentTab::setLargeFileMode(bool enable)
+{
+    largeFileMode = enable;
+    if (!enable)
+        largeFileView->closeFile();
+    largeFileView->setVisible(enable);
+    editor->setVisible(!enable);
+    if (enable)
+        largeFileView->setFocus();
+    else
+        editor->setFocus();
+}
+
+/**
+ * @brief DocumentTab::releaseLayout
+ * 切到后台时释放各段的排版结果（行、字形），保留每段的行数，
+ * 切回来时只有用到的段落会重新排版；释放在空闲时分片进行，切换本身不遍历文档
+ */
+void DocumentTab::releaseLayout()
+{
+    layoutPending = layoutPending || !layoutScheduler->isFinished();
+    layoutScheduler->release();
+}
+
+void DocumentTab::restoreLayout()
+{
+    layoutScheduler->cancel(); // 还没释放完的段落保留
+    if (layoutPending)
+        layoutScheduler->schedule();
+    layoutPending = false;
+}
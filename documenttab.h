@@ -0,0 +1,71 @@
+#ifndef DOCUMENTTAB_H
+#define DOCUMENTTAB_H
+
+#include <QWidget>
+#include <QPlainTextEdit>
+#include "dirtytracker.h"
+#include "fileloader.h"
+#include "filemonitor.h"
+#include "filesaver.h"
+#include "sessionjournal.h"
+#include "largefileview.h"
+#include "layoutscheduler.h"
+#include "searchengine.h"
+#include "textbuffer.h"
+#include "lineending.h"
+
+/**
+ * 一个标签页
+ * 每个打开的文档有自己的编辑器（或超大文件查看器）、路径、编码、换行符、
+ * 修改状态、恢复日志、后台读写、磁盘变化监视、查找结果和缩放比例；调度都在主窗口中
+ */
+class DocumentTab : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit DocumentTab(QWidget *parent = nullptr);
+    ~DocumentTab() override;
+
+    bool isModified() const;
+    bool isBlank() const;
+    void setLargeFileMode(bool enable);
+    void releaseLayout();
+    void restoreLayout();
+
+public:
+    QPlainTextEdit* editor;
+    LargeFileView* largeFileView;
+    TextBuffer* textBuffer;
+    DirtyTracker* dirtyTracker;
+    SessionJournal* journal;
+    FileSaver* fileSaver;
+    FileLoader* fileLoader;
+    FileMonitor* fileMonitor;
+    LayoutScheduler* layoutScheduler;
+    SearchEngine* searchEngine;
+
+    QString filePath;
+    QString fileName = "无标题";
+    QByteArray codecName = "UTF-8";
+    bool codecBom = false;
+    LineEnding::Style lineStyle = LineEnding::defaultStyle();
+    bool lineMixed = false;
+
+    DirtyTracker::Snapshot savingSnapshot;
+    bool savePending = false;
+    bool loading = false;
+    bool readOnlyBeforeLoading = false;
+    bool largeFileMode = false;
+    int loadPercent = 100;
+    int zoomSize = 100;
+    bool followTail = false; // 文件追加内容后滚动到末尾
+    int tailRevision = -1;   // 上一次追加后的文档版本，之后没有编辑时下一次追加并入同一步撤销
+
+    bool layoutPending = false; // 切到后台时还没排完
+
+    int lineCacheBlock = -1;   // 上一次光标所在段落及其起始显示行
+    int lineCacheRevision = -1;
+    int lineCacheFirstLine = 0;
+};
+
+#endif // DOCUMENTTAB_H
@@ -0,0 +1,268 @@
+#include <QTextCodec>
+#include <cstring>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "encodingdetector.h"
+
+static const int SAMPLE_SIZE = 64 * 1024; // 只检测开头这么多字节，大文件也是常数时间
+static const int INVALID_PENALTY = 10;
+
+/**
+ * @brief EncodingDetector::detect
+ * @param bomLength 输出 BOM 的字节数，解码时需要跳过
+ * @return QTextCodec 可识别的编码名
+ */
+QByteArray EncodingDetector::detect(const char *data, qint64 size, int *bomLength)
+{
+    const uchar* p = reinterpret_cast<const uchar*>(data);
+    if (bomLength)
+        *bomLength = 0;
+
+    // BOM
+    if (size >= 3 && p[0] == 0xEF && p[1] == 0xBB && p[2] == 0xBF)
+    {
+        if (bomLength)
+            *bomLength = 3;
+        return "UTF-8";
+    }
+    if (size >= 2 && p[0] == 0xFF && p[1] == 0xFE)
+    {
+        if (bomLength)
+            *bomLength = 2;
+        return "UTF-16LE";
+    }
+    if (size >= 2 && p[0] == 0xFE && p[1] == 0xFF)
+    {
+        if (bomLength)
+            *bomLength = 2;
+        return "UTF-16BE";
+    }
+
+    const int sample = static_cast<int>(qMin<qint64>(size, SAMPLE_SIZE));
+    QByteArray utf16 = detectUtf16(p, sample);
+    if (!utf16.isEmpty())
+        return utf16;
+
+    // 纯 ASCII 也归为 UTF-8；样本截断处可能切断多字节字符
+    if (isValidUtf8(data, sample, sample < size))
+        return "UTF-8";
+
+    int gbk = scoreGbk(p, sample);
+    int big5 = scoreBig5(p, sample);
+    int sjis = scoreShiftJis(p, sample);
+    if (gbk > 0 && gbk >= big5 && gbk >= sjis)
+        return "GBK";
+    if (big5 > 0 && big5 >= sjis)
+        return "Big5";
+    if (sjis > 0)
+        return "Shift_JIS";
+    return QTextCodec::codecForLocale()->name();
+}
+
+/**
+ * @brief EncodingDetector::isValidUtf8
+ * 连续的 ASCII 用 SSE2 一次跳过 16 字节，遇到多字节序列再逐个校验
+ * @param allowTruncatedTail 末尾不完整的多字节序列是否算合法
+ */
+bool EncodingDetector::isValidUtf8(const char *data, qint64 size, bool allowTruncatedTail)
+{
+    const uchar* p = reinterpret_cast<const uchar*>(data);
+    const uchar* end = p + size;
+    while (p < end)
+    {
+#ifdef __SSE2__
+        while (end - p >= 16)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            if (_mm_movemask_epi8(v)) // 有最高位为1的字节
+                break;
+            p += 16;
+        }
+#else
+        while (end - p >= 8)
+        {
+            quint64 v;
+            memcpy(&v, p, 8);
+            if (v & Q_UINT64_C(0x8080808080808080))
+                break;
+            p += 8;
+        }
+#endif
+        if (p >= end)
+            break;
+
+        const uchar c = *p;
+        if (c < 0x80)
+        {
+            p++;
+            continue;
+        }
+
+        int n; // 后续字节数
+        if (c >= 0xC2 && c <= 0xDF)
+            n = 1;
+        else if ((c & 0xF0) == 0xE0)
+            n = 2;
+        else if (c >= 0xF0 && c <= 0xF4)
+            n = 3;
+        else
+            return false;
+
+        if (end - p <= n)
+        {
+            if (!allowTruncatedTail)
+                return false;
+            for (const uchar* q = p + 1; q < end; q++)
+                if ((*q & 0xC0) != 0x80)
+                    return false;
+            return true;
+        }
+        for (int i = 1; i <= n; i++)
+            if ((p[i] & 0xC0) != 0x80)
+                return false;
+
+        // 过长编码和代理区
+        if ((c == 0xE0 && p[1] < 0xA0) || (c == 0xED && p[1] >= 0xA0)
+                || (c == 0xF0 && p[1] < 0x90) || (c == 0xF4 && p[1] >= 0x90))
+            return false;
+        p += n + 1;
+    }
+    return true;
+}
+
+QByteArray EncodingDetector::byteOrderMark(const QByteArray &codecName)
+{
+    if (codecName == "UTF-8")
+        return QByteArray("\xEF\xBB\xBF", 3);
+    if (codecName == "UTF-16LE")
+        return QByteArray("\xFF\xFE", 2);
+    if (codecName == "UTF-16BE")
+        return QByteArray("\xFE\xFF", 2);
+    return QByteArray();
+}
+
+/**
+ * @brief EncodingDetector::detectUtf16
+ * 没有 BOM 的 UTF-16 文本中，ASCII 字符的高位字节为0，集中出现在奇数或偶数位置
+ */
+QByteArray EncodingDetector::detectUtf16(const uchar *data, int size)
+{
+    if (size < 4)
+        return QByteArray();
+
+    int evenZeros = 0, oddZeros = 0;
+    const int units = size / 2;
+    for (int i = 0; i < units * 2; i += 2)
+    {
+        if (!data[i])
+            evenZeros++;
+        if (!data[i + 1])
+            oddZeros++;
+    }
+    if (oddZeros > units * 3 / 10 && evenZeros < units / 20)
+        return "UTF-16LE";
+    if (evenZeros > units * 3 / 10 && oddZeros < units / 20)
+        return "UTF-16BE";
+    return QByteArray();
+}
+
+/**
+ * @brief EncodingDetector::scoreGbk
+ * GB2312 的汉字区（B0-F7, A1-FE）加分，不合法的双字节序列扣分
+ */
+int EncodingDetector::scoreGbk(const uchar *data, int size)
+{
+    int score = 0;
+    int i = 0;
+    while (i < size)
+    {
+        const uchar c = data[i];
+        if (c < 0x80)
+        {
+            i++;
+            continue;
+        }
+        if (i + 1 >= size) // 样本截断
+            break;
+        const uchar t = data[i + 1];
+        if (c == 0x80 || c == 0xFF || t < 0x40 || t == 0x7F || t == 0xFF)
+        {
+            score -= INVALID_PENALTY;
+            i++;
+            continue;
+        }
+        if (c >= 0xB0 && c <= 0xF7 && t >= 0xA1)
+            score += 2;
+        else if (c >= 0xA1 && c <= 0xA9 && t >= 0xA1)
+            score += 1;
+        i += 2;
+    }
+    return score;
+}
+
+/**
+ * @brief EncodingDetector::scoreBig5
+ * Big5 常用字区（A4-C6）加分，次常用字和符号区少量加分
+ */
+int EncodingDetector::scoreBig5(const uchar *data, int size)
+{
+    int score = 0;
+    int i = 0;
+    while (i < size)
+    {
+        const uchar c = data[i];
+        if (c < 0x80)
+        {
+            i++;
+            continue;
+        }
+        if (i + 1 >= size)
+            break;
+        const uchar t = data[i + 1];
+        if (c < 0xA1 || c > 0xF9 || !((t >= 0x40 && t <= 0x7E) || (t >= 0xA1 && t <= 0xFE)))
+        {
+            score -= INVALID_PENALTY;
+            i++;
+            continue;
+        }
+        score += (c >= 0xA4 && c <= 0xC6) ? 2 : 1;
+        i += 2;
+    }
+    return score;
+}
+
+/**
+ * @brief EncodingDetector::scoreShiftJis
+ * 平假名、片假名加分较多，汉字少量加分
+ */
+int EncodingDetector::scoreShiftJis(const uchar *data, int size)
+{
+    int score = 0;
+    int i = 0;
+    while (i < size)
+    {
+        const uchar c = data[i];
+        if (c < 0x80 || (c >= 0xA1 && c <= 0xDF)) // ASCII 和半角片假名
+        {
+            i++;
+            continue;
+        }
+        if (i + 1 >= size)
+            break;
+        const uchar t = data[i + 1];
+        if (!((c >= 0x81 && c <= 0x9F) || (c >= 0xE0 && c <= 0xFC))
+                || t < 0x40 || t == 0x7F || t > 0xFC)
+        {
+            score -= INVALID_PENALTY;
+            i++;
+            continue;
+        }
+        if ((c == 0x82 && t >= 0x9F && t <= 0xF1) || (c == 0x83 && t <= 0x96))
+            score += 3;
+        else if (c >= 0x88 && c <= 0x9F)
+            score += 1;
+        i += 2;
+    }
+    return score;
+}
@@ -0,0 +1,25 @@
+#ifndef ENCODINGDETECTOR_H
+#define ENCODINGDETECTOR_H
+
+#include <QByteArray>
+
+/**
+ * 文本编码检测
+ * 只取文件开头固定大小的样本：先看 BOM，再按零字节分布判断无 BOM 的 UTF-16，
+ * 然后检查是否为合法 UTF-8，最后对 GBK/Big5/Shift_JIS 按常用字区间打分
+ */
+class EncodingDetector
+{
+public:
+    static QByteArray detect(const char* data, qint64 size, int* bomLength = nullptr);
+    static bool isValidUtf8(const char* data, qint64 size, bool allowTruncatedTail = false);
+    static QByteArray byteOrderMark(const QByteArray& codecName);
+
+private:
+    static QByteArray detectUtf16(const uchar* data, int size);
+    static int scoreGbk(const uchar* data, int size);
+    static int scoreBig5(const uchar* data, int size);
+    static int scoreShiftJis(const uchar* data, int size);
+};
+
+#endif // ENCODINGDETECTOR_H
@@ -0,0 +1,214 @@
+#include <QTextCodec>
+#include <QMutexLocker>
+#include <QtConcurrent/QtConcurrent>
+#include "fileloader.h"
+#include "encodingdetector.h"
+
+static const int FIRST_CHUNK_SIZE = 64 * 1024;   // 第一块小一点，尽快显示第一屏
+static const int CHUNK_SIZE = 1024 * 1024;
+static const int MAX_PENDING_CHUNKS = 4;
+
+FileLoader::FileLoader(QObject *parent) : QObject(parent), freeSlots(MAX_PENDING_CHUNKS)
+{
+}
+
+FileLoader::~FileLoader()
+{
+    cancel();
+    close();
+}
+
+bool FileLoader::open(const QString &path)
+{
+    close();
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    fileSize = file.size();
+    uchar* mapped = fileSize > 0 ? file.map(0, fileSize) : nullptr;
+    if (mapped)
+    {
+        data = reinterpret_cast<const char*>(mapped);
+    }
+    else
+    {
+        buffer = file.readAll();
+        fileSize = buffer.size();
+        data = buffer.constData();
+    }
+
+    codec = EncodingDetector::detect(data, fileSize, &bomLength);
+    QTextCodec* textCodec = QTextCodec::codecForName(codec);
+    if (!textCodec)
+    {
+        textCodec = QTextCodec::codecForLocale();
+        codec = textCodec->name();
+    }
+    decoder = textCodec->makeDecoder(QTextCodec::IgnoreHeader); // BOM 已单独跳过
+    pendingCR = false;
+    lineEndings.reset();
+    readOffset = bomLength;
+    return true;
+}
+
+void FileLoader::close()
+{
+    if (file.isOpen())
+        file.close(); // 同时解除映射
+    buffer.clear();
+    data = nullptr;
+    fileSize = 0;
+    bomLength = 0;
+    delete decoder;
+    decoder = nullptr;
+}
+
+qint64 FileLoader::size() const
+{
+    return fileSize;
+}
+
+QByteArray FileLoader::codecName() const
+{
+    return codec;
+}
+
+bool FileLoader::hasBom() const
+{
+    return bomLength > 0;
+}
+
+/**
+ * @brief FileLoader::lineEnding
+ * 后台读取时，需在 finished 之后调用
+ */
+LineEnding FileLoader::lineEnding() const
+{
+    return lineEndings;
+}
+
+/**
+ * @brief FileLoader::readAll
+ * 小文件直接在当前线程解码
+ */
+QString FileLoader::readAll()
+{
+    if (!decoder)
+        return QString();
+    return decodeChunk(data + bomLength, static_cast<int>(fileSize - bomLength), true);
+}
+
+/**
+ * @brief FileLoader::readChunk
+ * 在当前线程逐块解码（命令行批处理用），不必整个文件一次解码完
+ */
+QString FileLoader::readChunk()
+{
+    if (!decoder || atEnd())
+        return QString();
+    int len = static_cast<int>(qMin<qint64>(CHUNK_SIZE, fileSize - readOffset));
+    bool last = readOffset + len >= fileSize;
+    QString text = decodeChunk(data + readOffset, len, last);
+    readOffset += len;
+    return text;
+}
+
+bool FileLoader::atEnd() const
+{
+    return readOffset >= fileSize;
+}
+
+/**
+ * @brief FileLoader::start
+ * 在后台线程分块解码，通过 chunksReady 通知取走
+ */
+void FileLoader::start()
+{
+    cancel();
+    freeSlots.tryAcquire(freeSlots.available());
+    freeSlots.release(MAX_PENDING_CHUNKS);
+    pending.clear();
+    cancelled = 0;
+    running = 1;
+    future = QtConcurrent::run([this]{ run(); });
+}
+
+void FileLoader::cancel()
+{
+    if (!future.isRunning())
+        return ;
+    cancelled = 1;
+    freeSlots.release(MAX_PENDING_CHUNKS); // 唤醒等待中的后台线程
+    future.waitForFinished();
+    running = 0;
+    QMutexLocker locker(&mutex);
+    pending.clear();
+}
+
+bool FileLoader::isRunning() const
+{
+    return running.load();
+}
+
+/**
+ * @brief FileLoader::takeChunks
+ * 界面线程取走已解码的块，同时放行后台线程继续解码
+ */
+QStringList FileLoader::takeChunks()
+{
+    QStringList chunks;
+    {
+        QMutexLocker locker(&mutex);
+        chunks.swap(pending);
+    }
+    if (!chunks.isEmpty())
+        freeSlots.release(chunks.size());
+    return chunks;
+}
+
+void FileLoader::run()
+{
+    qint64 offset = bomLength;
+    int chunkSize = FIRST_CHUNK_SIZE;
+    while (offset < fileSize)
+    {
+        freeSlots.acquire();
+        if (cancelled.load())
+            return ;
+
+        int len = static_cast<int>(qMin<qint64>(chunkSize, fileSize - offset));
+        bool last = offset + len >= fileSize;
+        QString text = decodeChunk(data + offset, len, last);
+        offset += len;
+        chunkSize = CHUNK_SIZE;
+
+        {
+            QMutexLocker locker(&mutex);
+            pending.append(text);
+        }
+        emit chunksReady();
+        emit progress(offset, fileSize);
+    }
+    running = 0;
+    emit finished();
+}
+
+QString FileLoader::decodeChunk(const char *data, int len, bool last)
+{
+    QString text = decoder->toUnicode(data, len);
+    if (pendingCR)
+    {
+        text.prepend(QLatin1Char('\r'));
+        pendingCR = false;
+    }
+
+    // \r\n 被分到两块时会变成两个段落，把末尾的 \r 留给下一块
+    if (!last && text.endsWith(QLatin1Char('\r')))
+    {
+        text.chop(1);
+        pendingCR = true;
+    }
+    lineEndings.scan(text.constData(), text.length());
+    return text;
+}
@@ -0,0 +1,72 @@
+#ifndef FILELOADER_H
+#define FILELOADER_H
+
+#include <QObject>
+#include <QFile>
+#include <QFuture>
+#include <QMutex>
+#include <QSemaphore>
+#include <QStringList>
+#include <QAtomicInt>
+#include "lineending.h"
+
+class QTextDecoder;
+
+/**
+ * 文件读取
+ * 文件内存映射后先检测编码，再按固定大小分块解码，解码时顺带统计换行符，
+ * 小文件在当前线程一次性读完，大文件交给后台线程，
+ * 界面线程通过 takeChunks() 分批取走追加到文档中
+ */
+class FileLoader : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FileLoader(QObject *parent = nullptr);
+    ~FileLoader() override;
+
+    bool open(const QString& path);
+    void close();
+    qint64 size() const;
+    QByteArray codecName() const;
+    bool hasBom() const;
+    LineEnding lineEnding() const;
+
+    QString readAll();
+    QString readChunk();
+    bool atEnd() const;
+    void start();
+    void cancel();
+    bool isRunning() const;
+    QStringList takeChunks();
+
+signals:
+    void chunksReady();
+    void progress(qint64 done, qint64 total);
+    void finished();
+
+private:
+    void run();
+    QString decodeChunk(const char* data, int len, bool last);
+
+private:
+    QFile file;
+    QByteArray buffer; // 无法映射时的后备
+    const char* data = nullptr;
+    qint64 fileSize = 0;
+    QByteArray codec;
+    int bomLength = 0;
+    qint64 readOffset = 0; // readChunk() 读到的位置
+    QTextDecoder* decoder = nullptr;
+    bool pendingCR = false;
+    LineEnding lineEndings;
+
+    QFuture<void> future;
+    QAtomicInt running;
+    QAtomicInt cancelled;
+    QMutex mutex;
+    QStringList pending;
+    QSemaphore freeSlots; // 限制尚未被界面取走的块数，避免解码过快堆积内存
+};
+
+#endif // FILELOADER_H
@@ -0,0 +1,158 @@
+#include <QFile>
+#include <QFileInfo>
+#include <QTextCodec>
+#include "filemonitor.h"
+
+static const int CHECK_DELAY = 300;        // 毫秒
+static const int CHECKSUM_SIZE = 4 * 1024; // 开头、末尾各取这么多字节
+
+FileMonitor::FileMonitor(QObject *parent) : QObject(parent)
+{
+    checkTimer.setSingleShot(true);
+    checkTimer.setInterval(CHECK_DELAY);
+    connect(&checkTimer, &QTimer::timeout, this, &FileMonitor::check);
+    connect(&watcher, &QFileSystemWatcher::fileChanged, &checkTimer, [=]{ checkTimer.start(); });
+    connect(&watcher, &QFileSystemWatcher::directoryChanged, &checkTimer, [=]{ checkTimer.start(); });
+}
+
+FileMonitor::~FileMonitor()
+{
+}
+
+/**
+ * @brief FileMonitor::watch
+ * 以磁盘上的现状为准开始监视，打开、保存、重新载入或忽略改动后调用
+ * @param knownSize 已读入的字节数，-1 表示当前文件大小
+ */
+void FileMonitor::watch(const QString &path, const QByteArray &codec, qint64 knownSize)
+{
+    unwatch();
+    this->path = path;
+    QTextCodec* textCodec = QTextCodec::codecForName(codec);
+    if (!textCodec)
+        textCodec = QTextCodec::codecForLocale();
+    decoder.reset(textCodec->makeDecoder(QTextCodec::IgnoreHeader));
+
+    QFile file(path);
+    missing = !file.open(QIODevice::ReadOnly);
+    if (!missing)
+    {
+        this->knownSize = knownSize < 0 ? file.size() : qMin(knownSize, file.size());
+        knownModified = QFileInfo(file).lastModified();
+        updateChecksums(file);
+        watcher.addPath(path);
+        if (file.size() != this->knownSize) // 读取之后已经又写入了
+            checkTimer.start();
+    }
+    watcher.addPath(QFileInfo(path).absolutePath());
+}
+
+void FileMonitor::unwatch()
+{
+    checkTimer.stop();
+    if (!watcher.files().isEmpty())
+        watcher.removePaths(watcher.files());
+    if (!watcher.directories().isEmpty())
+        watcher.removePaths(watcher.directories());
+    path.clear();
+    knownSize = 0;
+    missing = false;
+    waiting = false;
+    pendingCR = false;
+}
+
+/**
+ * @brief FileMonitor::readAppended
+ * 从上次读到的位置读到文件末尾并解码，多字节字符和 \r\n 被截断时留到下一次
+ */
+QString FileMonitor::readAppended()
+{
+    waiting = false;
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly) || file.size() <= knownSize || !file.seek(knownSize))
+        return QString();
+
+    const QByteArray bytes = file.read(file.size() - knownSize);
+    knownSize += bytes.size();
+    knownModified = QFileInfo(file).lastModified();
+    updateChecksums(file);
+
+    QString text = decoder->toUnicode(bytes);
+    if (pendingCR)
+    {
+        text.prepend(QLatin1Char('\r'));
+        pendingCR = false;
+    }
+    if (text.endsWith(QLatin1Char('\r')))
+    {
+        text.chop(1);
+        pendingCR = true;
+    }
+    return text;
+}
+
+/**
+ * @brief FileMonitor::check
+ * 大小和修改时间都没变时不读文件，否则最多读两段校验
+ */
+void FileMonitor::check()
+{
+    if (path.isEmpty() || waiting)
+        return ;
+
+    const QFileInfo info(path);
+    if (!info.exists())
+    {
+        if (!missing)
+        {
+            missing = true;
+            emit removed();
+        }
+        return ;
+    }
+    if (!watcher.files().contains(path)) // 改名替换后原来的监视已失效
+        watcher.addPath(path);
+    if (missing) // 删除后又出现了
+    {
+        missing = false;
+        waiting = true;
+        emit rewritten();
+        return ;
+    }
+    if (info.size() == knownSize && info.lastModified() == knownModified)
+        return ;
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return ;
+    const qint64 length = qMin<qint64>(CHECKSUM_SIZE, knownSize);
+    if (file.size() >= knownSize && checksum(file, 0, length) == headSum
+            && checksum(file, knownSize - length, length) == tailSum)
+    {
+        if (file.size() == knownSize)
+        {
+            knownModified = info.lastModified(); // 只是改了时间
+            return ;
+        }
+        waiting = true;
+        emit appended();
+        return ;
+    }
+    waiting = true;
+    emit rewritten();
+}
+
+void FileMonitor::updateChecksums(QFile &file)
+{
+    const qint64 length = qMin<qint64>(CHECKSUM_SIZE, knownSize);
+    headSum = checksum(file, 0, length);
+    tailSum = checksum(file, knownSize - length, length);
+}
+
+quint16 FileMonitor::checksum(QFile &file, qint64 offset, qint64 len)
+{
+    if (!file.seek(offset))
+        return 0;
+    const QByteArray bytes = file.read(len);
+    return qChecksum(bytes.constData(), static_cast<uint>(bytes.size()));
+}
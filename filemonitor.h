@@ -0,0 +1,56 @@
+#ifndef FILEMONITOR_H
+#define FILEMONITOR_H
+
+#include <QObject>
+#include <QFileSystemWatcher>
+#include <QDateTime>
+#include <QTimer>
+#include <QScopedPointer>
+
+class QFile;
+class QTextDecoder;
+
+/**
+ * 磁盘文件变化监视
+ * 记下已读入的长度以及开头、末尾各一小段的校验和，文件变化后只比较这两段：
+ * 都没变且变长了是追加，readAppended() 只读取并解码新增的部分；否则是被改写。
+ * 同时监视所在目录，文件被替换（保存到临时文件再改名）或删除后重新出现也能发现
+ */
+class FileMonitor : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FileMonitor(QObject *parent = nullptr);
+    ~FileMonitor() override;
+
+    void watch(const QString& path, const QByteArray& codec, qint64 knownSize = -1);
+    void unwatch();
+    QString readAppended();
+
+signals:
+    void appended();
+    void rewritten();
+    void removed();
+
+private slots:
+    void check();
+
+private:
+    void updateChecksums(QFile& file);
+    static quint16 checksum(QFile& file, qint64 offset, qint64 len);
+
+private:
+    QFileSystemWatcher watcher;
+    QTimer checkTimer; // 连续写入时合并成一次检查
+    QString path;
+    qint64 knownSize = 0;
+    QDateTime knownModified;
+    quint16 headSum = 0;
+    quint16 tailSum = 0;
+    bool missing = false;
+    bool waiting = false; // 已报告变化，等待读取追加部分、重新载入或忽略
+    QScopedPointer<QTextDecoder> decoder;
+    bool pendingCR = false;
+};
+
+#endif // FILEMONITOR_H
@@ -0,0 +1,109 @@
+#include <QSaveFile>
+#include <QTextCodec>
+#include <QScopedPointer>
+#include <QtConcurrent/QtConcurrent>
+#include "filesaver.h"
+#include "encodingdetector.h"
+#include "dirtytracker.h"
+
+static const int ENCODE_CHUNK_SIZE = 1024 * 1024; // 每次编码的字符数
+
+FileSaver::FileSaver(QObject *parent) : QObject(parent)
+{
+    connect(&watcher, &QFutureWatcher<Result>::finished, this, &FileSaver::deliver);
+}
+
+FileSaver::~FileSaver()
+{
+    future.waitForFinished();
+}
+
+/**
+ * @brief FileSaver::save
+ * text 是界面线程取出的快照（只复制了片段列表），之后的编辑不会影响本次保存
+ */
+void FileSaver::save(const QString &path, const PieceTable &text, const QByteArray &codec, bool bom, LineEnding::Style style)
+{
+    waitForFinished();
+    savingPath = path;
+    delivered = false;
+    future = QtConcurrent::run([=]{
+        return write(path, text, codec, bom, style);
+    });
+    watcher.setFuture(future);
+}
+
+bool FileSaver::isRunning() const
+{
+    return !delivered;
+}
+
+/**
+ * @brief FileSaver::waitForFinished
+ * 阻塞等待当前的保存完成，并立即发出 finished 信号
+ */
+void FileSaver::waitForFinished()
+{
+    if (delivered)
+        return ;
+    future.waitForFinished();
+    deliver();
+}
+
+void FileSaver::deliver()
+{
+    if (delivered)
+        return ;
+    delivered = true;
+    const Result result = future.result();
+    emit finished(result.error.isEmpty(), savingPath, result.error, result.hash);
+}
+
+/**
+ * @brief FileSaver::write
+ * 写入成功后再对同一份快照计算哈希，界面线程不必遍历文档
+ */
+FileSaver::Result FileSaver::write(const QString &path, const PieceTable &text, const QByteArray &codec, bool bom, LineEnding::Style style)
+{
+    Result result;
+    QTextCodec* textCodec = QTextCodec::codecForName(codec);
+    if (!textCodec)
+    {
+        result.error = "不支持的编码：" + QString(codec);
+        return result;
+    }
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        result.error = file.errorString();
+        return result;
+    }
+    if (bom)
+        file.write(EncodingDetector::byteOrderMark(codec));
+
+    // 分块编码，顺便把 \n 换回原来的换行符
+    QScopedPointer<QTextEncoder> encoder(textCodec->makeEncoder(QTextCodec::IgnoreHeader));
+    const QString separator = LineEnding::separator(style);
+    for (int i = 0; i < text.length(); i += ENCODE_CHUNK_SIZE)
+    {
+        QString chunk = text.mid(i, ENCODE_CHUNK_SIZE);
+        if (style != LineEnding::LF)
+            chunk.replace('\n', separator);
+        if (file.write(encoder->fromUnicode(chunk)) < 0)
+        {
+            result.error = file.errorString();
+            file.cancelWriting();
+            return result;
+        }
+    }
+
+    // 刷到磁盘后再替换原文件
+    if (!file.commit())
+    {
+        result.error = file.errorString();
+        return result;
+    }
+    result.hash = DirtyTracker::textHash(text);
+    return result;
+}
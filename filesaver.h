@@ -0,0 +1,46 @@
+#ifndef FILESAVER_H
+#define FILESAVER_H
+
+#include <QObject>
+#include <QFuture>
+#include <QFutureWatcher>
+#include "lineending.h"
+#include "piecetable.h"
+
+/**
+ * 文件保存
+ * 在后台线程编码并写入临时文件，刷到磁盘后再替换原文件（QSaveFile），
+ * 写到一半崩溃也不会损坏原来的文件；修改状态用的哈希也在后台线程计算
+ */
+class FileSaver : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FileSaver(QObject *parent = nullptr);
+    ~FileSaver() override;
+
+    void save(const QString& path, const PieceTable& text, const QByteArray& codec, bool bom, LineEnding::Style style);
+    bool isRunning() const;
+    void waitForFinished();
+
+signals:
+    void finished(bool ok, const QString& path, const QString& error, uint hash);
+
+private:
+    struct Result
+    {
+        QString error; // 成功时为空
+        uint hash = 0; // 所保存内容的哈希，见 DirtyTracker::textHash()
+    };
+
+    void deliver();
+    static Result write(const QString& path, const PieceTable& text, const QByteArray& codec, bool bom, LineEnding::Style style);
+
+private:
+    QString savingPath;
+    QFuture<Result> future;
+    QFutureWatcher<Result> watcher;
+    bool delivered = true;
+};
+
+#endif // FILESAVER_H
@@ -1,7 +1,7 @@
 #include "finddialog.h"
 #include "ui_finddialog.h"
 
-FindDialog::FindDialog(QSettings &settings, QWidget *parent) :
+FindDialog::FindDialog(SettingsCache &settings, QWidget *parent) :
     QDialog(parent),
     ui(new Ui::FindDialog),
     settings(settings)
@@ -14,6 +14,8 @@ FindDialog::FindDialog(QSettings &settings, QWidget *parent) :
     ui->replaceEdit->setText(settings.value("find/replaceText").toString());
     ui->caseSensitiveCheck->setChecked(settings.value("find/caseSensitive").toBool());
     ui->loopCheck->setChecked(settings.value("find/loop").toBool());
+    ui->regexCheck->setChecked(settings.value("find/regex").toBool());
+    ui->wholeWordCheck->setChecked(settings.value("find/wholeWord").toBool());
     if (!settings.value("find/down", true).toBool())
         ui->upRadio->setChecked(true);
 }
@@ -61,6 +63,37 @@ bool FindDialog::isLoop() const
     return ui->loopCheck->isChecked();
 }
 
+bool FindDialog::isRegex() const
+{
+    return ui->regexCheck->isChecked();
+}
+
+bool FindDialog::isWholeWord() const
+{
+    return ui->wholeWordCheck->isChecked();
+}
+
+/**
+ * @brief FindDialog::setMatchInfo
+ * 显示匹配数量；current 为 0 表示光标不在匹配上，total 为负表示还没统计完
+ */
+void FindDialog::setMatchInfo(int current, int total)
+{
+    if (total < 0)
+        ui->countLabel->clear();
+    else if (total == 0)
+        ui->countLabel->setText("找不到");
+    else if (current > 0)
+        ui->countLabel->setText("第 " + QString::number(current) + " 个，共 " + QString::number(total) + " 个");
+    else
+        ui->countLabel->setText("共 " + QString::number(total) + " 个");
+}
+
+void FindDialog::setMessage(const QString &message)
+{
+    ui->countLabel->setText(message);
+}
+
 void FindDialog::on_findNextButton_clicked()
 {
     if (ui->upRadio->isChecked())
@@ -90,6 +123,7 @@ void FindDialog::on_cancelButton_clicked()
 void FindDialog::on_caseSensitiveCheck_clicked()
 {
     settings.setValue("find/caseSensitive", ui->caseSensitiveCheck->isChecked());
+    emit signalPatternChanged();
 }
 
 void FindDialog::on_loopCheck_clicked()
@@ -97,6 +131,18 @@ void FindDialog::on_loopCheck_clicked()
     settings.setValue("find/loop", ui->loopCheck->isChecked());
 }
 
+void FindDialog::on_regexCheck_clicked()
+{
+    settings.setValue("find/regex", ui->regexCheck->isChecked());
+    emit signalPatternChanged();
+}
+
+void FindDialog::on_wholeWordCheck_clicked()
+{
+    settings.setValue("find/wholeWord", ui->wholeWordCheck->isChecked());
+    emit signalPatternChanged();
+}
+
 void FindDialog::on_upRadio_clicked()
 {
     settings.setValue("find/down", false);
@@ -129,3 +175,8 @@ void FindDialog::on_replaceEdit_returnPressed()
 {
     on_replaceButton_clicked();
 }
+
+void FindDialog::on_findEdit_textChanged(const QString&)
+{
+    emit signalPatternChanged();
+}
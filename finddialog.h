@@ -2,7 +2,7 @@
 #define FINDDIALOG_H
 
 #include <QDialog>
-#include <QSettings>
+#include "settingscache.h"
 
 namespace Ui {
 class FindDialog;
@@ -13,7 +13,7 @@ class FindDialog : public QDialog
     Q_OBJECT
 
 public:
-    explicit FindDialog(QSettings& settings, QWidget *parent = nullptr);
+    explicit FindDialog(SettingsCache& settings, QWidget *parent = nullptr);
     ~FindDialog() override;
 
     void openFind(bool replace);
@@ -21,7 +21,7 @@ public:
 signals:
     void signalShow();
     void signalHide();
-    // void signalTextChanged(const QString& text);
+    void signalPatternChanged();
     void signalFindNext();
     void signalFindPrev();
     void signalReplaceNext();
@@ -32,6 +32,10 @@ public:
     const QString getReplaceText() const;
     bool isCaseSensitive() const;
     bool isLoop() const;
+    bool isRegex() const;
+    bool isWholeWord() const;
+    void setMatchInfo(int current, int total);
+    void setMessage(const QString& message);
 
 private slots:
     void on_findNextButton_clicked();
@@ -46,12 +50,18 @@ private slots:
 
     void on_loopCheck_clicked();
 
+    void on_regexCheck_clicked();
+
+    void on_wholeWordCheck_clicked();
+
     void on_upRadio_clicked();
 
     void on_downRadio_clicked();
 
     void on_findEdit_returnPressed();
 
+    void on_findEdit_textChanged(const QString&);
+
     void on_replaceEdit_returnPressed();
 
 protected:
@@ -60,7 +70,7 @@ protected:
 
 private:
     Ui::FindDialog *ui;
-    QSettings& settings;
+    SettingsCache& settings;
 };
 
 #endif // FINDDIALOG_H
@@ -0,0 +1,76 @@
+#include <QMessageBox>
+#include <QRegularExpressionValidator>
+#include "gotodialog.h"
+#include "ui_gotodialog.h"
+
+GotoDialog::GotoDialog(QWidget *parent) :
+    QDialog(parent),
+    ui(new Ui::GotoDialog)
+{
+    ui->setupUi(this);
+    this->setWindowFlag(Qt::WindowContextHelpButtonHint, false);
+    ui->lineEdit->setValidator(new QRegularExpressionValidator(QRegularExpression("\\d{1,18}"), this));
+}
+
+GotoDialog::~GotoDialog()
+{
+    delete ui;
+}
+
+void GotoDialog::setLineCounts(qint64 logicalLines, qint64 visualLines)
+{
+    this->logicalLines = logicalLines;
+    this->visualLines = visualLines;
+}
+
+/**
+ * @brief GotoDialog::setCurrentLine
+ * @param line 从 1 开始
+ */
+void GotoDialog::setCurrentLine(qint64 line)
+{
+    ui->lineEdit->setText(QString::number(line));
+    ui->lineEdit->selectAll();
+}
+
+void GotoDialog::setVisualLine(bool visual)
+{
+    ui->visualCheck->setChecked(visual);
+}
+
+void GotoDialog::setVisualLineEnabled(bool enabled)
+{
+    ui->visualCheck->setEnabled(enabled);
+}
+
+/**
+ * @brief GotoDialog::line
+ * @return 从 1 开始的行号
+ */
+qint64 GotoDialog::line() const
+{
+    return ui->lineEdit->text().toLongLong();
+}
+
+bool GotoDialog::isVisualLine() const
+{
+    return ui->visualCheck->isEnabled() && ui->visualCheck->isChecked();
+}
+
+void GotoDialog::on_gotoButton_clicked()
+{
+    const qint64 max = isVisualLine() ? visualLines : logicalLines;
+    if (line() < 1 || line() > max)
+    {
+        QMessageBox::information(this, "记事本 - 跳行", "行数超过了总行数");
+        ui->lineEdit->setFocus();
+        ui->lineEdit->selectAll();
+        return ;
+    }
+    accept();
+}
+
+void GotoDialog::on_cancelButton_clicked()
+{
+    reject();
+}
@@ -0,0 +1,41 @@
+#ifndef GOTODIALOG_H
+#define GOTODIALOG_H
+
+#include <QDialog>
+
+namespace Ui {
+class GotoDialog;
+}
+
+/**
+ * 转到指定行
+ * 可以按段落（文件中的行）或按自动换行后显示的行跳转，后者与状态栏的行号一致
+ */
+class GotoDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit GotoDialog(QWidget *parent = nullptr);
+    ~GotoDialog() override;
+
+    void setLineCounts(qint64 logicalLines, qint64 visualLines);
+    void setCurrentLine(qint64 line);
+    void setVisualLine(bool visual);
+    void setVisualLineEnabled(bool enabled);
+
+    qint64 line() const;
+    bool isVisualLine() const;
+
+private slots:
+    void on_gotoButton_clicked();
+
+    void on_cancelButton_clicked();
+
+private:
+    Ui::GotoDialog *ui;
+    qint64 logicalLines = 1;
+    qint64 visualLines = 1;
+};
+
+#endif // GOTODIALOG_H
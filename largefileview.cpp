@@ -0,0 +1,469 @@
+#include <QPainter>
+#include <QScrollBar>
+#include <QKeyEvent>
+#include <QMouseEvent>
+#include <QTextCodec>
+#include <QtConcurrent/QtConcurrent>
+#include <cstring>
+#include <climits>
+#include "largefileview.h"
+#include "encodingdetector.h"
+
+static const int TEXT_MARGIN = 4;
+static const qint64 MAX_LINE_BYTES = 64 * 1024; // 超长的行只显示开头部分
+static const int LINE_ENDING_SAMPLE = 64 * 1024;
+static const qint64 FIND_BLOCK_SIZE = 4 * 1024 * 1024; // 查找时每块检查一次是否取消
+
+LargeFileView::LargeFileView(QWidget *parent)
+    : QAbstractScrollArea(parent),
+      index(new LineIndex(this)),
+      codec(QTextCodec::codecForLocale())
+{
+    setFrameShape(QFrame::NoFrame);
+    setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOn);
+    setFocusPolicy(Qt::StrongFocus);
+    viewport()->setCursor(Qt::IBeamCursor);
+
+    // 索引边扫描边可用，滚动范围随之增长
+    connect(index, &LineIndex::progress, this, [=](qint64 scanned, qint64 total){
+        updateScrollBars();
+        viewport()->update();
+        emit indexProgress(total ? static_cast<int>(scanned * 100 / total) : 100);
+    });
+    connect(index, &LineIndex::finished, this, [=]{
+        updateScrollBars();
+        viewport()->update();
+    });
+    connect(&findWatcher, &QFutureWatcher<qint64>::finished, this, &LargeFileView::onFindFinished);
+}
+
+LargeFileView::~LargeFileView()
+{
+    closeFile();
+}
+
+bool LargeFileView::openFile(const QString &path)
+{
+    closeFile();
+    error.clear();
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        error = file.errorString();
+        return false;
+    }
+
+    size = file.size();
+    uchar* mapped = file.map(0, size);
+    if (!mapped)
+    {
+        error = "无法映射文件：" + file.errorString();
+        file.close();
+        size = 0;
+        return false;
+    }
+    data = reinterpret_cast<const char*>(mapped);
+
+    // 行索引按字节 '\n' 切分，只支持兼容 ASCII 的编码
+    QByteArray name = EncodingDetector::detect(data, size);
+    codec = QTextCodec::codecForName(name);
+    if (!codec || name.startsWith("UTF-16"))
+    {
+        error = "不支持以 " + QString(name) + " 编码查看超大文件";
+        closeFile();
+        codec = QTextCodec::codecForLocale();
+        return false;
+    }
+
+    // 换行符只统计开头一段
+    lineEndings.reset();
+    lineEndings.scan(data, static_cast<int>(qMin<qint64>(size, LINE_ENDING_SAMPLE)));
+
+    cursorLine = 0;
+    cursorColumn = 0;
+    matchOffset = -1;
+    widestLine = 0;
+    verticalScrollBar()->setValue(0);
+    horizontalScrollBar()->setValue(0);
+    index->build(data, size);
+    updateScrollBars();
+    viewport()->update();
+    emit cursorPositionChanged(0, 0);
+    return true;
+}
+
+void LargeFileView::closeFile()
+{
+    cancelFind(); // 解除映射前等后台查找退出
+    index->cancel();
+    if (file.isOpen())
+        file.close();
+    data = nullptr;
+    size = 0;
+    matchOffset = -1;
+}
+
+/**
+ * @brief LargeFileView::errorString
+ * 上一次 openFile() 失败的原因
+ */
+QString LargeFileView::errorString() const
+{
+    return error;
+}
+
+bool LargeFileView::isOpen() const
+{
+    return data != nullptr;
+}
+
+QByteArray LargeFileView::codecName() const
+{
+    return codec->name();
+}
+
+LineEnding LargeFileView::lineEnding() const
+{
+    return lineEndings;
+}
+
+qint64 LargeFileView::lineCount() const
+{
+    return data ? index->lineCount() : 0;
+}
+
+/**
+ * @brief LargeFileView::currentLine
+ * @return 光标所在的行，从0开始
+ */
+qint64 LargeFileView::currentLine() const
+{
+    return cursorLine;
+}
+
+int LargeFileView::currentColumn() const
+{
+    return cursorColumn;
+}
+
+/**
+ * @brief LargeFileView::gotoLine
+ * @param line 从0开始的行号
+ */
+void LargeFileView::gotoLine(qint64 line)
+{
+    cancelFind();
+    matchOffset = -1;
+    moveCursorTo(line, 0);
+}
+
+/**
+ * @brief LargeFileView::find
+ * 起点在界面线程算好，扫描交给后台线程，结果由 findFinished 通知；
+ * 新的查找、按键、点击、关闭文件都会取消还没完成的查找
+ */
+void LargeFileView::find(const QString &text, bool caseSensitive, bool backward, bool loop)
+{
+    cancelFind();
+    if (!data || text.isEmpty())
+    {
+        emit findFinished(false);
+        return ;
+    }
+
+    findNeedle = codec->fromUnicode(text);
+    findTextLength = text.length();
+    qint64 from;
+    if (matchOffset >= 0)
+        from = backward ? matchOffset : matchOffset + matchLength;
+    else
+        from = index->lineStart(cursorLine) + codec->fromUnicode(lineText(cursorLine).left(cursorColumn)).size();
+
+    const char* d = data;
+    const qint64 total = size;
+    const QByteArray needle = findNeedle;
+    const QAtomicInt* flag = &findCancelled;
+    findCancelled = 0;
+    findFuture = QtConcurrent::run([=]() -> qint64 {
+        qint64 pos = backward ? searchBytes(d, needle, 0, from, caseSensitive, true, flag)
+                              : searchBytes(d, needle, from, total, caseSensitive, false, flag);
+        if (pos < 0 && loop && !flag->load()) // 没找到，从另一头开始
+            pos = searchBytes(d, needle, 0, total, caseSensitive, backward, flag);
+        return pos;
+    });
+    findWatcher.setFuture(findFuture);
+}
+
+void LargeFileView::cancelFind()
+{
+    if (!findFuture.isRunning())
+        return ;
+    findCancelled = 1;
+    findFuture.waitForFinished(); // 每块检查一次，很快退出
+}
+
+void LargeFileView::onFindFinished()
+{
+    if (findCancelled.load() || !findFuture.isFinished() || findFuture.isCanceled())
+        return ;
+    const qint64 pos = findFuture.result();
+    if (pos < 0 || !data)
+    {
+        emit findFinished(false);
+        return ;
+    }
+
+    matchOffset = pos;
+    matchLength = findNeedle.size();
+    qint64 line = index->lineForOffset(pos);
+    qint64 start = index->lineStart(line);
+    int column = codec->toUnicode(data + start, static_cast<int>(pos - start)).length();
+    moveCursorTo(line, column + findTextLength);
+    emit findFinished(true);
+}
+
+void LargeFileView::paintEvent(QPaintEvent *)
+{
+    QPainter painter(viewport());
+    if (!data)
+        return ;
+
+    const QFontMetrics fm(font());
+    const int lineHeight = fm.height();
+    const int x0 = TEXT_MARGIN - horizontalScrollBar()->value();
+    const qint64 top = verticalScrollBar()->value();
+    const qint64 total = lineCount();
+    const int rows = visibleLineCount();
+    const qint64 matchLine = matchOffset >= 0 ? index->lineForOffset(matchOffset) : -1;
+
+    int widest = widestLine;
+    for (int i = 0; i < rows && top + i < total; i++)
+    {
+        const qint64 line = top + i;
+        const QString text = lineText(line);
+        const int y = i * lineHeight;
+        painter.setPen(palette().color(QPalette::Text));
+        painter.drawText(x0, y + fm.ascent(), text);
+        widest = qMax(widest, fm.horizontalAdvance(text));
+
+        if (line == matchLine) // 查找结果
+        {
+            qint64 start = index->lineStart(line);
+            int col = codec->toUnicode(data + start, static_cast<int>(matchOffset - start)).length();
+            int len = codec->toUnicode(data + matchOffset, matchLength).length();
+            int x = x0 + fm.horizontalAdvance(text.left(col));
+            painter.fillRect(x, y, fm.horizontalAdvance(text.mid(col, len)), lineHeight, palette().highlight());
+            painter.setPen(palette().color(QPalette::HighlightedText));
+            painter.drawText(x, y + fm.ascent(), text.mid(col, len));
+        }
+        if (line == cursorLine && hasFocus())
+        {
+            int x = x0 + fm.horizontalAdvance(text.left(cursorColumn));
+            painter.fillRect(x, y, 1, lineHeight, palette().color(QPalette::Text));
+        }
+    }
+
+    if (widest != widestLine)
+    {
+        widestLine = widest;
+        horizontalScrollBar()->setRange(0, qMax(0, widestLine + TEXT_MARGIN * 2 - viewport()->width()));
+    }
+}
+
+void LargeFileView::resizeEvent(QResizeEvent *e)
+{
+    QAbstractScrollArea::resizeEvent(e);
+    updateScrollBars();
+}
+
+void LargeFileView::keyPressEvent(QKeyEvent *e)
+{
+    const int page = visibleLineCount();
+    const bool ctrl = e->modifiers() & Qt::ControlModifier;
+    cancelFind();
+    matchOffset = -1;
+    switch (e->key())
+    {
+    case Qt::Key_Up:
+        moveCursorTo(cursorLine - 1, cursorColumn);
+        break;
+    case Qt::Key_Down:
+        moveCursorTo(cursorLine + 1, cursorColumn);
+        break;
+    case Qt::Key_PageUp:
+        moveCursorTo(cursorLine - page, cursorColumn);
+        break;
+    case Qt::Key_PageDown:
+        moveCursorTo(cursorLine + page, cursorColumn);
+        break;
+    case Qt::Key_Left:
+        moveCursorTo(cursorLine, cursorColumn - 1);
+        break;
+    case Qt::Key_Right:
+        moveCursorTo(cursorLine, cursorColumn + 1);
+        break;
+    case Qt::Key_Home:
+        moveCursorTo(ctrl ? 0 : cursorLine, 0);
+        break;
+    case Qt::Key_End:
+        if (ctrl)
+            moveCursorTo(lineCount() - 1, 0);
+        else
+            moveCursorTo(cursorLine, lineText(cursorLine).length());
+        break;
+    default:
+        QAbstractScrollArea::keyPressEvent(e);
+        return ;
+    }
+}
+
+void LargeFileView::mousePressEvent(QMouseEvent *e)
+{
+    const QFontMetrics fm(font());
+    qint64 line = verticalScrollBar()->value() + e->pos().y() / fm.height();
+    const QString text = lineText(line);
+
+    // 按字符宽度累加，找到点击位置最近的列
+    int x = e->pos().x() - TEXT_MARGIN + horizontalScrollBar()->value();
+    int column = 0, advance = 0;
+    while (column < text.length())
+    {
+        int w = fm.horizontalAdvance(text.at(column));
+        if (advance + w / 2 > x)
+            break;
+        advance += w;
+        column++;
+    }
+
+    cancelFind();
+    matchOffset = -1;
+    setFocus();
+    moveCursorTo(line, column);
+}
+
+QString LargeFileView::lineText(qint64 line) const
+{
+    if (!data || line < 0 || line >= lineCount())
+        return QString();
+    qint64 start = index->lineStart(line);
+    qint64 end = index->lineEnd(line);
+    return codec->toUnicode(data + start, static_cast<int>(qMin(end - start, MAX_LINE_BYTES)));
+}
+
+int LargeFileView::visibleLineCount() const
+{
+    return viewport()->height() / QFontMetrics(font()).height() + 1;
+}
+
+void LargeFileView::updateScrollBars()
+{
+    const int lines = static_cast<int>(qMin<qint64>(lineCount(), INT_MAX));
+    const int page = visibleLineCount() - 1;
+    verticalScrollBar()->setPageStep(page);
+    verticalScrollBar()->setRange(0, qMax(0, lines - page));
+    horizontalScrollBar()->setPageStep(viewport()->width());
+    horizontalScrollBar()->setRange(0, qMax(0, widestLine + TEXT_MARGIN * 2 - viewport()->width()));
+}
+
+void LargeFileView::moveCursorTo(qint64 line, int column)
+{
+    line = qBound<qint64>(0, line, qMax<qint64>(0, lineCount() - 1));
+    column = qBound(0, column, lineText(line).length());
+    cursorLine = line;
+    cursorColumn = column;
+
+    // 保持光标可见
+    const int page = visibleLineCount() - 1;
+    if (line < verticalScrollBar()->value())
+        verticalScrollBar()->setValue(static_cast<int>(line));
+    else if (line >= verticalScrollBar()->value() + page)
+        verticalScrollBar()->setValue(static_cast<int>(line - page + 1));
+
+    viewport()->update();
+    emit cursorPositionChanged(cursorLine, cursorColumn);
+}
+
+/**
+ * @brief LargeFileView::searchBytes
+ * 在 [from, to) 范围内分块查找，每块检查一次是否取消；
+ * 向前查找时在块内正向找到最后一个，同样可以用 memchr 跳过
+ * @return 匹配的字节偏移，没找到或已取消返回 -1
+ */
+qint64 LargeFileView::searchBytes(const char *data, const QByteArray &needle, qint64 from, qint64 to,
+                                  bool caseSensitive, bool backward, const QAtomicInt *cancelled)
+{
+    const int n = needle.size();
+    if (n == 0 || to - from < n)
+        return -1;
+
+    const qint64 end = to - n + 1; // 匹配起点的上界（不含）
+    if (!backward)
+    {
+        for (qint64 start = from; start < end; start += FIND_BLOCK_SIZE)
+        {
+            if (cancelled->load())
+                return -1;
+            const qint64 pos = firstMatch(data, needle, start, qMin(end, start + FIND_BLOCK_SIZE), caseSensitive);
+            if (pos >= 0)
+                return pos;
+        }
+        return -1;
+    }
+
+    for (qint64 stop = end; stop > from; stop -= FIND_BLOCK_SIZE)
+    {
+        if (cancelled->load())
+            return -1;
+        const qint64 start = qMax(from, stop - FIND_BLOCK_SIZE);
+        qint64 last = -1;
+        for (qint64 pos = firstMatch(data, needle, start, stop, caseSensitive); pos >= 0;
+             pos = firstMatch(data, needle, pos + 1, stop, caseSensitive))
+            last = pos;
+        if (last >= 0)
+            return last;
+    }
+    return -1;
+}
+
+/**
+ * @brief LargeFileView::firstMatch
+ * 起点在 [from, to) 内的第一个匹配，用 memchr 定位首字节；
+ * 不区分大小写只折叠 ASCII 字母，首字节是字母时分别找大写和小写
+ */
+qint64 LargeFileView::firstMatch(const char *data, const QByteArray &needle, qint64 from, qint64 to, bool caseSensitive)
+{
+    const int n = needle.size();
+    auto fold = [](char c) -> char {
+        return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+    };
+    auto equals = [&](const char* p) -> bool {
+        if (caseSensitive)
+            return memcmp(p, needle.constData(), static_cast<size_t>(n)) == 0;
+        for (int i = 0; i < n; i++)
+            if (fold(p[i]) != fold(needle.at(i)))
+                return false;
+        return true;
+    };
+
+    const char lower = caseSensitive ? needle.at(0) : fold(needle.at(0));
+    const char upper = (!caseSensitive && lower >= 'a' && lower <= 'z') ? static_cast<char>(lower - ('a' - 'A')) : lower;
+    const char* p = data + from;
+    const char* last = data + to; // 候选起点不含 last
+    while (p < last)
+    {
+        const size_t len = static_cast<size_t>(last - p);
+        const char* a = static_cast<const char*>(memchr(p, lower, len));
+        if (upper != lower)
+        {
+            const char* b = static_cast<const char*>(memchr(p, upper, a ? static_cast<size_t>(a - p) : len));
+            if (b)
+                a = b;
+        }
+        if (!a)
+            return -1;
+        if (equals(a))
+            return a - data;
+        p = a + 1;
+    }
+    return -1;
+}
@@ -0,0 +1,83 @@
+#ifndef LARGEFILEVIEW_H
+#define LARGEFILEVIEW_H
+
+#include <QAbstractScrollArea>
+#include <QFile>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QAtomicInt>
+#include "lineindex.h"
+#include "lineending.h"
+
+class QTextCodec;
+
+/**
+ * 超大文件只读查看
+ * 文件内存映射，后台建立行索引，只解码并绘制可见的几行，
+ * 查找在后台线程直接扫描映射的字节，完成后再移动光标
+ */
+class LargeFileView : public QAbstractScrollArea
+{
+    Q_OBJECT
+public:
+    explicit LargeFileView(QWidget *parent = nullptr);
+    ~LargeFileView() override;
+
+    bool openFile(const QString& path);
+    void closeFile();
+    bool isOpen() const;
+    QString errorString() const;
+    QByteArray codecName() const;
+    LineEnding lineEnding() const;
+
+    qint64 lineCount() const;
+    qint64 currentLine() const;
+    int currentColumn() const;
+    void gotoLine(qint64 line);
+    void find(const QString& text, bool caseSensitive, bool backward, bool loop);
+    void cancelFind();
+
+signals:
+    void cursorPositionChanged(qint64 line, int column);
+    void indexProgress(int percent);
+    void findFinished(bool found);
+
+protected:
+    void paintEvent(QPaintEvent *) override;
+    void resizeEvent(QResizeEvent *) override;
+    void keyPressEvent(QKeyEvent *e) override;
+    void mousePressEvent(QMouseEvent *e) override;
+
+private:
+    QString lineText(qint64 line) const;
+    int visibleLineCount() const;
+    void updateScrollBars();
+    void moveCursorTo(qint64 line, int column);
+    void onFindFinished();
+    static qint64 searchBytes(const char* data, const QByteArray& needle, qint64 from, qint64 to,
+                              bool caseSensitive, bool backward, const QAtomicInt* cancelled);
+    static qint64 firstMatch(const char* data, const QByteArray& needle, qint64 from, qint64 to, bool caseSensitive);
+
+private:
+    QFile file;
+    const char* data = nullptr;
+    qint64 size = 0;
+    LineIndex* index;
+    QTextCodec* codec;
+    LineEnding lineEndings;
+    QString error; // openFile() 失败的原因
+
+    qint64 cursorLine = 0;
+    int cursorColumn = 0;
+    qint64 matchOffset = -1; // 查找结果（字节偏移）
+    int matchLength = 0;
+
+    QFuture<qint64> findFuture;
+    QFutureWatcher<qint64> findWatcher;
+    QAtomicInt findCancelled;
+    QByteArray findNeedle; // 正在查找的内容
+    int findTextLength = 0;
+    int widestLine = 0;
+};
+
+#endif // LARGEFILEVIEW_H
@@ -0,0 +1,113 @@
+#include <QPlainTextEdit>
+#include <QTextBlock>
+#include <QAbstractTextDocumentLayout>
+#include <QElapsedTimer>
+#include "layoutscheduler.h"
+
+static const int SLICE_BUDGET = 8;       // 每片最多占用的毫秒数
+static const int BLOCKS_PER_CHECK = 64;  // 每排这么多段看一次时间
+
+LayoutScheduler::LayoutScheduler(QPlainTextEdit *edit, QObject *parent)
+    : QObject(parent), edit(edit)
+{
+    sliceTimer.setSingleShot(true);
+    sliceTimer.setInterval(0); // 处理完已有的事件之后才运行
+    connect(&sliceTimer, &QTimer::timeout, this, &LayoutScheduler::runSlice);
+}
+
+/**
+ * @brief LayoutScheduler::schedule
+ * 排版被清空之后调用，从当前可见的第一段开始重新排
+ */
+void LayoutScheduler::schedule()
+{
+    startBlock = nextBlock = edit->cursorForPosition(QPoint(0, 0)).blockNumber();
+    wrapped = false;
+    releasing = false;
+    sliceTimer.start();
+}
+
+/**
+ * @brief LayoutScheduler::release
+ * 分片释放各段的排版结果（保留行数），不在一次切换中遍历全部段落
+ */
+void LayoutScheduler::release()
+{
+    nextBlock = 0;
+    releasing = true;
+    sliceTimer.start();
+}
+
+void LayoutScheduler::cancel()
+{
+    sliceTimer.stop();
+    releasing = false;
+}
+
+/**
+ * @brief LayoutScheduler::isFinished
+ * 排版是否已全部完成（正在释放时不算未完成）
+ */
+bool LayoutScheduler::isFinished() const
+{
+    return releasing || !sliceTimer.isActive();
+}
+
+/**
+ * @brief LayoutScheduler::runSlice
+ * blockBoundingRect 会排版还没排过的段落；排版期间屏蔽逐段发出的尺寸变化，
+ * 每片结束时只通知一次，滚动条随之变准
+ */
+void LayoutScheduler::runSlice()
+{
+    if (releasing)
+    {
+        releaseSlice();
+        return ;
+    }
+
+    QTextDocument* doc = edit->document();
+    QAbstractTextDocumentLayout* layout = doc->documentLayout();
+    const int end = wrapped ? qMin(startBlock, doc->blockCount()) : doc->blockCount();
+
+    QElapsedTimer timer;
+    timer.start();
+    bool blocked = layout->blockSignals(true);
+    QTextBlock block = doc->findBlockByNumber(nextBlock); // 两片之间可能有编辑，按段号重新定位
+    while (block.isValid() && nextBlock < end)
+    {
+        layout->blockBoundingRect(block);
+        block = block.next();
+        if (++nextBlock % BLOCKS_PER_CHECK == 0 && timer.elapsed() >= SLICE_BUDGET)
+            break;
+    }
+    layout->blockSignals(blocked);
+    emit layout->documentSizeChanged(layout->documentSize());
+
+    if (nextBlock >= end || !block.isValid())
+    {
+        if (wrapped || startBlock == 0)
+            return ; // 全部排完
+        wrapped = true;
+        nextBlock = 0;
+    }
+    sliceTimer.start();
+}
+
+void LayoutScheduler::releaseSlice()
+{
+    QElapsedTimer timer;
+    timer.start();
+    QTextBlock block = edit->document()->findBlockByNumber(nextBlock);
+    while (block.isValid())
+    {
+        block.clearLayout();
+        block = block.next();
+        if (++nextBlock % BLOCKS_PER_CHECK == 0 && timer.elapsed() >= SLICE_BUDGET)
+            break;
+    }
+    if (block.isValid())
+        sliceTimer.start();
+    else
+        releasing = false;
+}
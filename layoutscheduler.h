@@ -0,0 +1,42 @@
+#ifndef LAYOUTSCHEDULER_H
+#define LAYOUTSCHEDULER_H
+
+#include <QObject>
+#include <QTimer>
+
+class QPlainTextEdit;
+
+/**
+ * 空闲时分片排版
+ * 切换自动换行、缩放、改字体后 QPlainTextEdit 只清空排版，用到哪段才排哪段，
+ * 没排版的段落按一行估算（行号、滚动条都不准）。
+ * 这里从可见区域开始，在事件循环空闲时每次排几毫秒，直到全部排完。
+ * 切到后台时也用同样的分片逐段释放排版结果
+ */
+class LayoutScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    explicit LayoutScheduler(QPlainTextEdit* edit, QObject *parent = nullptr);
+
+    void schedule();
+    void release();
+    void cancel();
+    bool isFinished() const;
+
+private slots:
+    void runSlice();
+
+private:
+    void releaseSlice();
+
+private:
+    QPlainTextEdit* edit;
+    QTimer sliceTimer;
+    int startBlock = 0; // 从可见区域的第一段开始
+    int nextBlock = 0;
+    bool wrapped = false; // 已排到末尾，回到开头排可见区域之前的部分
+    bool releasing = false;
+};
+
+#endif // LAYOUTSCHEDULER_H
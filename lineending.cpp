@@ -0,0 +1,143 @@
+#include <QtAlgorithms>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "lineending.h"
+
+/**
+ * 统计 p[i] 处的换行符
+ * @return 下一个要检查的位置
+ */
+template <typename T>
+static inline int countAt(const T* p, int i, int len, qint64& crlf, qint64& lf, qint64& cr)
+{
+    if (p[i] == '\r')
+    {
+        if (i + 1 < len && p[i + 1] == '\n')
+        {
+            crlf++;
+            return i + 2;
+        }
+        cr++;
+    }
+    else if (p[i] == '\n')
+    {
+        lf++;
+    }
+    return i + 1;
+}
+
+void LineEnding::reset()
+{
+    crlf = lf = cr = 0;
+}
+
+void LineEnding::scan(const QChar *data, int len)
+{
+    const ushort* p = reinterpret_cast<const ushort*>(data);
+    int i = 0;
+#ifdef __SSE2__
+    const __m128i vcr = _mm_set1_epi16('\r');
+    const __m128i vlf = _mm_set1_epi16('\n');
+#endif
+    while (i < len)
+    {
+#ifdef __SSE2__
+        if (i + 8 <= len)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+            int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi16(v, vcr), _mm_cmpeq_epi16(v, vlf)));
+            if (!mask)
+            {
+                i += 8;
+                continue;
+            }
+            i += static_cast<int>(qCountTrailingZeroBits(static_cast<quint32>(mask))) / 2;
+        }
+#endif
+        i = countAt(p, i, len, crlf, lf, cr);
+    }
+}
+
+void LineEnding::scan(const char *data, int len)
+{
+    int i = 0;
+#ifdef __SSE2__
+    const __m128i vcr = _mm_set1_epi8('\r');
+    const __m128i vlf = _mm_set1_epi8('\n');
+#endif
+    while (i < len)
+    {
+#ifdef __SSE2__
+        if (i + 16 <= len)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, vcr), _mm_cmpeq_epi8(v, vlf)));
+            if (!mask)
+            {
+                i += 16;
+                continue;
+            }
+            i += static_cast<int>(qCountTrailingZeroBits(static_cast<quint32>(mask)));
+        }
+#endif
+        i = countAt(data, i, len, crlf, lf, cr);
+    }
+}
+
+/**
+ * @brief LineEnding::style
+ * 取出现最多的一种，没有换行符时使用系统默认
+ */
+LineEnding::Style LineEnding::style() const
+{
+    if (!crlf && !lf && !cr)
+        return defaultStyle();
+    if (crlf >= lf && crlf >= cr)
+        return CRLF;
+    if (lf >= cr)
+        return LF;
+    return CR;
+}
+
+bool LineEnding::isMixed() const
+{
+    return (crlf > 0) + (lf > 0) + (cr > 0) > 1;
+}
+
+LineEnding::Style LineEnding::defaultStyle()
+{
+#ifdef Q_OS_WIN
+    return CRLF;
+#else
+    return LF;
+#endif
+}
+
+QString LineEnding::label(Style style)
+{
+    switch (style)
+    {
+    case CRLF:
+        return "Windows (CRLF)";
+    case LF:
+        return "Unix (LF)";
+    case CR:
+        return "Macintosh (CR)";
+    }
+    return QString();
+}
+
+QString LineEnding::separator(LineEnding::Style style)
+{
+    switch (style)
+    {
+    case CRLF:
+        return "\r\n";
+    case LF:
+        return "\n";
+    case CR:
+        return "\r";
+    }
+    return "\n";
+}
@@ -0,0 +1,38 @@
+#ifndef LINEENDING_H
+#define LINEENDING_H
+
+#include <QString>
+
+/**
+ * 换行符统计
+ * 解码时顺带扫描每一块，用 SSE2 一次比较多个字符，没有换行符的部分直接跳过
+ * \r\n 不能跨块，调用方需要保证块末尾的 \r 留到下一块
+ */
+class LineEnding
+{
+public:
+    enum Style
+    {
+        CRLF,
+        LF,
+        CR
+    };
+
+    void reset();
+    void scan(const QChar* data, int len);
+    void scan(const char* data, int len);
+
+    Style style() const;
+    bool isMixed() const;
+
+    static Style defaultStyle();
+    static QString label(Style style);
+    static QString separator(Style style);
+
+private:
+    qint64 crlf = 0;
+    qint64 lf = 0;
+    qint64 cr = 0;
+};
+
+#endif // LINEENDING_H
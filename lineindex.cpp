@@ -0,0 +1,156 @@
+#include <QMutexLocker>
+#include <QtConcurrent/QtConcurrent>
+#include <algorithm>
+#include <cstring>
+#include "lineindex.h"
+
+static const int LINES_PER_CHECKPOINT = 64;
+static const qint64 SCAN_BLOCK_SIZE = 4 * 1024 * 1024; // 每扫完一块发布一次结果
+
+LineIndex::LineIndex(QObject *parent) : QObject(parent)
+{
+}
+
+LineIndex::~LineIndex()
+{
+    cancel();
+}
+
+void LineIndex::build(const char *data, qint64 size)
+{
+    cancel();
+    this->data = data;
+    this->size = size;
+    {
+        QMutexLocker locker(&mutex);
+        checkpoints.clear();
+        checkpoints.append(0);
+        newlineCount = 0;
+    }
+    cancelled = 0;
+    done = 0;
+    future = QtConcurrent::run([this]{ run(); });
+}
+
+void LineIndex::cancel()
+{
+    if (!future.isRunning())
+        return ;
+    cancelled = 1;
+    future.waitForFinished();
+}
+
+bool LineIndex::isFinished() const
+{
+    return done.load();
+}
+
+/**
+ * @brief LineIndex::lineCount
+ * 扫描中只返回已经确定的完整行数
+ */
+qint64 LineIndex::lineCount() const
+{
+    QMutexLocker locker(&mutex);
+    return done.load() ? newlineCount + 1 : newlineCount;
+}
+
+qint64 LineIndex::lineStart(qint64 line) const
+{
+    if (line <= 0)
+        return 0;
+
+    qint64 index, offset;
+    {
+        QMutexLocker locker(&mutex);
+        index = qMin<qint64>(line / LINES_PER_CHECKPOINT, checkpoints.size() - 1);
+        offset = checkpoints.at(static_cast<int>(index));
+    }
+    return skipLines(offset, line - index * LINES_PER_CHECKPOINT);
+}
+
+/**
+ * @brief LineIndex::lineEnd
+ * @return 行尾偏移，不包含换行符
+ */
+qint64 LineIndex::lineEnd(qint64 line) const
+{
+    qint64 start = lineStart(line);
+    const char* nl = static_cast<const char*>(memchr(data + start, '\n', static_cast<size_t>(size - start)));
+    qint64 end = nl ? nl - data : size;
+    if (end > start && data[end - 1] == '\r')
+        end--;
+    return end;
+}
+
+qint64 LineIndex::lineForOffset(qint64 offset) const
+{
+    offset = qBound<qint64>(0, offset, size);
+    qint64 index, start;
+    {
+        QMutexLocker locker(&mutex);
+        auto it = std::upper_bound(checkpoints.constBegin(), checkpoints.constEnd(), offset);
+        index = (it - checkpoints.constBegin()) - 1;
+        start = checkpoints.at(static_cast<int>(index));
+    }
+
+    qint64 line = index * LINES_PER_CHECKPOINT;
+    const char* p = data + start;
+    const char* e = data + offset;
+    while (p < e && (p = static_cast<const char*>(memchr(p, '\n', static_cast<size_t>(e - p)))))
+    {
+        p++;
+        line++;
+    }
+    return line;
+}
+
+void LineIndex::run()
+{
+    qint64 offset = 0;
+    qint64 lines = 0;
+    QVector<qint64> found;
+    while (offset < size)
+    {
+        if (cancelled.load())
+            return ;
+
+        const char* p = data + offset;
+        const char* e = data + qMin(size, offset + SCAN_BLOCK_SIZE);
+        while (p < e && (p = static_cast<const char*>(memchr(p, '\n', static_cast<size_t>(e - p)))))
+        {
+            p++;
+            if (++lines % LINES_PER_CHECKPOINT == 0)
+                found.append(p - data);
+        }
+        offset = e - data;
+
+        {
+            QMutexLocker locker(&mutex);
+            checkpoints += found;
+            newlineCount = lines;
+        }
+        found.clear();
+        emit progress(offset, size);
+    }
+    done = 1;
+    emit finished();
+}
+
+/**
+ * @brief LineIndex::skipLines
+ * 从 offset 开始跳过 count 个换行符
+ */
+qint64 LineIndex::skipLines(qint64 offset, qint64 count) const
+{
+    const char* p = data + offset;
+    const char* e = data + size;
+    while (count-- > 0)
+    {
+        const char* nl = static_cast<const char*>(memchr(p, '\n', static_cast<size_t>(e - p)));
+        if (!nl)
+            return size;
+        p = nl + 1;
+    }
+    return p - data;
+}
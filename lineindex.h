@@ -0,0 +1,52 @@
+#ifndef LINEINDEX_H
+#define LINEINDEX_H
+
+#include <QObject>
+#include <QVector>
+#include <QFuture>
+#include <QMutex>
+#include <QAtomicInt>
+
+/**
+ * 行首偏移索引
+ * 后台扫描内存映射的文件内容，每 LINES_PER_CHECKPOINT 行记录一次行首偏移，
+ * 查询时从最近的检查点往后数换行符，多 GB 的文件也只占几 MB 内存
+ */
+class LineIndex : public QObject
+{
+    Q_OBJECT
+public:
+    explicit LineIndex(QObject *parent = nullptr);
+    ~LineIndex() override;
+
+    void build(const char* data, qint64 size);
+    void cancel();
+    bool isFinished() const;
+
+    qint64 lineCount() const;
+    qint64 lineStart(qint64 line) const;
+    qint64 lineEnd(qint64 line) const;
+    qint64 lineForOffset(qint64 offset) const;
+
+signals:
+    void progress(qint64 scanned, qint64 total);
+    void finished();
+
+private:
+    void run();
+    qint64 skipLines(qint64 offset, qint64 count) const;
+
+private:
+    const char* data = nullptr;
+    qint64 size = 0;
+
+    mutable QMutex mutex;
+    QVector<qint64> checkpoints; // 第 i*LINES_PER_CHECKPOINT 行的行首
+    qint64 newlineCount = 0;     // 已扫描到的换行符数量
+
+    QFuture<void> future;
+    QAtomicInt cancelled;
+    QAtomicInt done;
+};
+
+#endif // LINEINDEX_H
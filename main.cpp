@@ -1,27 +1,64 @@
 #include <QApplication>
+#include <QFileInfo>
 #include <QDebug>
 #include "mainwindow.h"
+#include "singleinstance.h"
+#include "startuptrace.h"
+#include "batchprocessor.h"
 
 int main(int argc, char *argv[])
 {
+    StartupTrace::start(argc, argv);
+    if (BatchProcessor::isRequested(argc, argv))
+    {
+        // 批处理不需要窗口
+        QCoreApplication app(argc, argv);
+        app.setApplicationName("notepad");
+        app.setApplicationVersion("v0.1");
+        return BatchProcessor::run(app.arguments());
+    }
+
     QApplication a(argc, argv);
+    StartupTrace::mark("QApplication");
+
+    a.setApplicationName("notepad");
+    a.setApplicationVersion("v0.1");
+    a.setApplicationDisplayName("记事本");
+
+    // 已经有实例在运行：把文件交给它打开，自己直接退出，不创建窗口；
+    // 工作目录不同，转发绝对路径。arguments() 中已去掉 Qt 自己的参数（如 -platform）
+    QStringList paths;
+    const QStringList args = a.arguments();
+    for (int i = 1; i < args.size(); i++)
+    {
+        if (args.at(i) != "--trace-startup")
+            paths << QFileInfo(args.at(i)).absoluteFilePath();
+    }
+    SingleInstance instance;
+    if (instance.sendToRunning(paths))
+    {
+        StartupTrace::mark("已交给运行中的实例");
+        return 0;
+    }
+    instance.listen(); // 之前一直持有启动锁，这时才让后启动的进程连接
 
     QFont f(a.font());
     f.setFamily("微软雅黑");
     a.setFont(f);
 
-    a.setApplicationName("notepad");
-    a.setApplicationVersion("v0.1");
-    a.setApplicationDisplayName("记事本");
+    // 转发来的文件在最近激活的窗口中打开
+    QObject::connect(&instance, &SingleInstance::argumentsReceived, [](const QStringList& paths){
+        if (MainWindow* w = MainWindow::activeInstance())
+            w->openFromInstance(paths);
+    });
 
     MainWindow w;
     w.show();
 
-    if (argc == 2)
-    {
-        QString path = QString::fromLocal8Bit(argv[1]);
+    // 每个文件打开到一个标签页
+    for (const QString& path: paths)
         w.openFile(path);
-    }
+    w.checkRecovery();
 
     return a.exec();
 }
@@ -1,27 +1,47 @@
 #include <QMessageBox>
 #include <QFileDialog>
 #include <QDebug>
-#include <QProcess>
 #include <QDesktopServices>
 #include <QDateTime>
 #include <QFontDialog>
 #include <QTextBlock>
+#include <QTextBoundaryFinder>
 #include <QFileIconProvider>
+#include <QScrollBar>
+#include <QAbstractTextDocumentLayout>
+#include <QResizeEvent>
+#include <QWheelEvent>
+#include <QGestureEvent>
+#include <QPinchGesture>
+#include <QNativeGestureEvent>
+#include <QPointer>
+#include <QApplication>
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
+#include "gotodialog.h"
+#include "startuptrace.h"
+
+// 超过这个大小的文件在后台分块读取
+static const qint64 STREAM_OPEN_THRESHOLD = 4 * 1024 * 1024;
+// 超过这个大小的文件默认使用只读查看模式（可通过 largeFile/threshold 设置）
+static const qint64 LARGE_FILE_THRESHOLD = 512 * 1024 * 1024;
+// 一屏内最多高亮的匹配数（不换行时一屏可能很宽）
+static const int MAX_SEARCH_HIGHLIGHTS = 2000;
+
+static QPointer<MainWindow> lastActiveWindow; // 最近一次激活的窗口，转发的文件在这里打开
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow),
-      settings("MyNotepad")
+      settings(SettingsCache::instance())
 {
     ui->setupUi(this);
+    StartupTrace::mark("setupUi");
 
     // 读取设置
     if (!settings.value("wordWrap", true).toBool())
     {
         ui->actionWord_Wrap_W->setChecked(false);
-        ui->plainTextEdit->setWordWrapMode(QTextOption::NoWrap);
     }
     if (!settings.value("statusBar", true).toBool())
     {
@@ -29,239 +49,1188 @@ MainWindow::MainWindow(QWidget *parent)
         ui->actionStatus_Bar_S->setChecked(false);
     }
 
-    // 恢复字体
+    // 恢复字体，缩放都基于这个字体
+    baseFont = this->font();
     QString fs;
     if (!(fs = settings.value("font").toString()).isEmpty())
-    {
-        QFont f;
-        f.fromString(fs);
-        ui->plainTextEdit->setFont(f);
-    }
+        baseFont.fromString(fs);
+
+    // 连续的滚轮、手势缩放合并为一次排版
+    zoomTimer.setSingleShot(true);
+    zoomTimer.setInterval(30);
+    connect(&zoomTimer, &QTimer::timeout, this, [=]{
+        applyZoom(currentTab());
+    });
 
-    // 状态栏
+    // 光标移动、选择、编辑时合并到下一帧再刷新状态栏
+    statusTimer.setSingleShot(true);
+    statusTimer.setInterval(16);
+    connect(&statusTimer, &QTimer::timeout, this, &MainWindow::updateStatusBar);
+
+    // 关键词变化后重新统计，高亮只画可见范围内的匹配
+    searchPatternTimer.setSingleShot(true);
+    searchPatternTimer.setInterval(200);
+    connect(&searchPatternTimer, &QTimer::timeout, this, &MainWindow::updateSearchPattern);
+    highlightTimer.setSingleShot(true);
+    highlightTimer.setInterval(0);
+    connect(&highlightTimer, &QTimer::timeout, this, &MainWindow::updateSearchHighlights);
+
+    // 标签页
+    connect(ui->tabWidget, &QTabWidget::currentChanged, this, &MainWindow::onCurrentTabChanged);
+    connect(ui->tabWidget, &QTabWidget::tabCloseRequested, this, &MainWindow::onTabCloseRequested);
+    createTab();
+
+    // 首次绘制之后再做其余的初始化
+    this->installEventFilter(this);
+    StartupTrace::mark("主窗口构造完成");
+}
+
+MainWindow::~MainWindow()
+{
+    delete ui;
+}
+
+/**
+ * @brief MainWindow::initDeferred
+ * 不影响首屏的初始化放到第一次绘制之后：状态栏、右键菜单、窗口图标、恢复日志
+ */
+void MainWindow::initDeferred()
+{
+    createStatusBar();
+    syncCurrentTab(); // 之前打开的文件此时才显示到状态栏上
+    if (!contextMenu)
+        createContextMenu();
+    StartupTrace::mark("状态栏、右键菜单");
+
+#ifdef Q_OS_WIN
+    // 设置为系统notepad图标
+    QFileIconProvider ip;
+    QIcon icon = ip.icon(QFileInfo("C:\\Windows\\System32\\notepad.exe"));
+    qApp->setWindowIcon(icon);
+#endif
+
+    if (recoveryPending)
+        checkRecovery();
+    StartupTrace::mark("延后的初始化完成");
+}
+
+/**
+ * @brief MainWindow::createStatusBar
+ * 状态栏的各项和大文件读取进度（只显示当前标签页的）
+ */
+void MainWindow::createStatusBar()
+{
     posLabel = new QLabel("第 1 行，第 1 列", this);
+    charLabel = new QLabel("0 个字符", this);
     zoomLabel = new QLabel("100%", this);
-    lineLabel = new QLabel("Windows (CRLF)", this);
-    codecLabel = new QLabel("GBK", this);
+    lineLabel = new QLabel(LineEnding::label(LineEnding::defaultStyle()), this);
+    codecLabel = new QLabel("UTF-8", this);
     ui->statusbar->addPermanentWidget(new QLabel(this), 6);
     ui->statusbar->addPermanentWidget(posLabel, 3);
+    ui->statusbar->addPermanentWidget(charLabel, 2);
     ui->statusbar->addPermanentWidget(zoomLabel, 1);
     ui->statusbar->addPermanentWidget(lineLabel, 3);
     ui->statusbar->addPermanentWidget(codecLabel, 1);
 
-    // 设置为系统notepad图标
-    QFileIconProvider ip;
-    QIcon icon = ip.icon(QFileInfo("C:\\Windows\\System32\\notepad.exe"));
-    qApp->setWindowIcon(icon);
+    loadProgress = new QProgressBar(this);
+    loadProgress->setRange(0, 100);
+    loadProgress->setMaximumWidth(160);
+    loadCancelButton = new QPushButton("取消", this);
+    ui->statusbar->addWidget(loadProgress);
+    ui->statusbar->addWidget(loadCancelButton);
+    loadProgress->hide();
+    loadCancelButton->hide();
+    connect(loadCancelButton, &QPushButton::clicked, this, [=]{
+        DocumentTab* tab = currentTab();
+        if (!tab || !tab->loading)
+            return ;
+        tab->fileLoader->cancel();
+        finishLoading(tab, true);
+    });
 }
 
-MainWindow::~MainWindow()
+DocumentTab *MainWindow::currentTab() const
 {
-    delete ui;
+    return qobject_cast<DocumentTab*>(ui->tabWidget->currentWidget());
+}
+
+DocumentTab *MainWindow::tabAt(int index) const
+{
+    return qobject_cast<DocumentTab*>(ui->tabWidget->widget(index));
+}
+
+/**
+ * @brief MainWindow::createTab
+ * 新建一个空白标签页并切换过去；各文档的信号都带上所属的标签页，
+ * 只有当前标签页会刷新状态栏和菜单
+ */
+DocumentTab *MainWindow::createTab()
+{
+    DocumentTab* tab = new DocumentTab(ui->tabWidget);
+    QPlainTextEdit* edit = tab->editor;
+    QTextDocument* doc = edit->document();
+    if (!ui->actionWord_Wrap_W->isChecked())
+        edit->setWordWrapMode(QTextOption::NoWrap);
+    applyZoom(tab);
+
+    connect(edit, &QPlainTextEdit::textChanged, this, [=]{
+        if (tab == currentTab())
+            onEditorTextChanged();
+    });
+    connect(edit, &QPlainTextEdit::undoAvailable, this, [=](bool b){
+        if (tab == currentTab())
+            onEditorUndoAvailable(b);
+    });
+    connect(edit, &QPlainTextEdit::selectionChanged, this, [=]{
+        if (tab == currentTab())
+            onEditorSelectionChanged();
+    });
+    connect(edit, &QPlainTextEdit::cursorPositionChanged, this, [=]{
+        if (tab == currentTab())
+            onEditorCursorPositionChanged();
+    });
+    connect(edit, &QPlainTextEdit::customContextMenuRequested, this, &MainWindow::onEditorContextMenuRequested);
+
+    // 修改状态只在变化时刷新标题
+    connect(doc, &QTextDocument::modificationChanged, this, [=]{
+        updateWindowTitle(tab);
+    });
+    connect(doc, &QTextDocument::contentsChanged, this, [=]{
+        if (tab == currentTab())
+            scheduleStatusBar();
+    });
+    connect(doc->documentLayout(), &QAbstractTextDocumentLayout::documentSizeChanged, this, [=]{
+        tab->lineCacheBlock = -1; // 重新排版后各段的显示行数可能变了
+        if (tab == currentTab())
+            scheduleStatusBar();
+    });
+
+    // 换行、缩放、字体、宽度变化后在空闲时排版
+    edit->viewport()->installEventFilter(this);
+    edit->viewport()->grabGesture(Qt::PinchGesture);
+
+    // 后台保存、读取
+    connect(tab->fileSaver, &FileSaver::finished, this, [=](bool ok, const QString& path, const QString& error, uint hash){
+        tab->savingSnapshot.hash = hash;
+        tab->savingSnapshot.hashed = true;
+        finishSave(tab, ok, path, error);
+    });
+    connect(tab->fileLoader, &FileLoader::chunksReady, this, [=]{
+        appendLoadedChunks(tab);
+    });
+    connect(tab->fileLoader, &FileLoader::progress, this, [=](qint64 done, qint64 total){
+        tab->loadPercent = total ? static_cast<int>(done * 100 / total) : 100;
+        if (tab == currentTab())
+            updateLoadProgress();
+    });
+    connect(tab->fileLoader, &FileLoader::finished, this, [=]{
+        if (tab->fileLoader->isRunning()) // 上一次读取遗留的信号
+            return ;
+        finishLoading(tab, false);
+    });
+
+    // 其他程序修改了打开的文件
+    connect(tab->fileMonitor, &FileMonitor::appended, this, [=]{
+        appendFileTail(tab);
+    });
+    connect(tab->fileMonitor, &FileMonitor::rewritten, this, [=]{
+        askReload(tab);
+    });
+    connect(tab->fileMonitor, &FileMonitor::removed, this, [=]{
+        ui->statusbar->showMessage(tab->fileName + " 已被删除或移动", 5000);
+    });
+
+    // 超大文件只读查看
+    connect(tab->largeFileView, &LargeFileView::cursorPositionChanged, this, [=](qint64 line, int col){
+        if (tab == currentTab() && posLabel)
+            posLabel->setText(QString("第 %1 行，第 %2 列").arg(line + 1).arg(col + 1));
+    });
+    connect(tab->largeFileView, &LargeFileView::findFinished, this, [=](bool found){
+        if (tab == currentTab() && findDialog)
+            findDialog->setMatchInfo(0, found ? -1 : 0);
+    });
+    connect(tab->largeFileView, &LargeFileView::indexProgress, this, [=](int percent){
+        tab->loadPercent = percent;
+        if (tab == currentTab())
+            updateLoadProgress();
+    });
+
+    // 查找结果与高亮
+    connect(tab->searchEngine, &SearchEngine::matchesChanged, this, [=]{
+        if (tab != currentTab() || !findDialog)
+            return ;
+        updateMatchInfo();
+        highlightTimer.start();
+        runQueuedFind();
+    });
+    connect(edit->verticalScrollBar(), &QScrollBar::valueChanged, &highlightTimer, [=]{
+        highlightTimer.start();
+    });
+    connect(edit->horizontalScrollBar(), &QScrollBar::valueChanged, &highlightTimer, [=]{
+        highlightTimer.start();
+    });
+
+    ui->tabWidget->setCurrentIndex(ui->tabWidget->addTab(tab, tab->fileName));
+    return tab;
 }
 
+/**
+ * @brief MainWindow::blankTab
+ * 打开文件时，当前是空白的标签页就直接使用，否则新建一个
+ */
+DocumentTab *MainWindow::blankTab()
+{
+    DocumentTab* tab = currentTab();
+    if (tab && tab->isBlank())
+        return tab;
+    return createTab();
+}
+
+/**
+ * @brief MainWindow::closeTab
+ * @return 是否已关闭（可能选择了取消）
+ */
+bool MainWindow::closeTab(DocumentTab *tab)
+{
+    if (tab->loading)
+    {
+        tab->fileLoader->cancel();
+        finishLoading(tab, true);
+    }
+    if (!askSave(tab))
+        return false;
+    tab->journal->discard(); // 已保存或选择了不保存
+
+    // 关闭最后一个标签页即关闭窗口；先换上一个空白标签页，窗口里始终有当前标签页，
+    // 关闭后仍在运行的定时器、查找框，以及之后转发到这个窗口的文件都不会遇到空的标签页
+    const bool last = ui->tabWidget->count() == 1;
+    if (last)
+        createTab();
+    if (tab == previousTab)
+        previousTab = nullptr;
+    ui->tabWidget->removeTab(ui->tabWidget->indexOf(tab));
+    tab->deleteLater();
+    if (last)
+        this->close();
+    return true;
+}
+
+/**
+ * @brief MainWindow::onCurrentTabChanged
+ * 切到后台的标签页清掉查找结果并释放排版，只保留当前标签页的
+ */
+void MainWindow::onCurrentTabChanged(int index)
+{
+    DocumentTab* tab = tabAt(index);
+    if (previousTab && previousTab != tab)
+    {
+        if (zoomTimer.isActive())
+        {
+            zoomTimer.stop();
+            applyZoom(previousTab);
+        }
+        previousTab->searchEngine->clear();
+        previousTab->textBuffer->release(); // 查找结果已清掉，后台标签页不必跟随
+        queuedFind = NoQueuedFind;
+        previousTab->editor->setExtraSelections(QList<QTextEdit::ExtraSelection>());
+        previousTab->releaseLayout();
+    }
+    previousTab = tab;
+    if (!tab)
+        return ;
+
+    tab->restoreLayout();
+    syncCurrentTab();
+    if (findDialog && findDialog->isVisible())
+        updateSearchPattern();
+    if (tab->largeFileMode)
+        tab->largeFileView->setFocus();
+    else
+        tab->editor->setFocus();
+}
+
+void MainWindow::onTabCloseRequested(int index)
+{
+    if (DocumentTab* tab = tabAt(index))
+        closeTab(tab);
+}
+
+/**
+ * @brief MainWindow::syncCurrentTab
+ * 状态栏、菜单状态、标题改为当前标签页的
+ */
+void MainWindow::syncCurrentTab()
+{
+    DocumentTab* tab = currentTab();
+    if (!tab)
+        return ;
+
+    if (posLabel) // 状态栏还没创建时，创建后会再同步一次
+    {
+        codecLabel->setText(tab->codecBom ? "带有 BOM 的 " + QString(tab->codecName) : QString(tab->codecName));
+        lineLabel->setText(LineEnding::label(tab->lineStyle) + (tab->lineMixed ? "，混合" : ""));
+        zoomLabel->setText(QString::number(tab->zoomSize) + "%");
+        charLabel->setVisible(!tab->largeFileMode);
+        shownLine = shownColumn = shownSelection = shownChars = -1;
+        if (tab->largeFileMode)
+            posLabel->setText(QString("第 %1 行，第 %2 列").arg(tab->largeFileView->currentLine() + 1).arg(tab->largeFileView->currentColumn() + 1));
+        else
+            scheduleStatusBar();
+        updateLoadProgress();
+    }
+
+    ui->actionSave->setEnabled(!tab->largeFileMode);
+    ui->actionSave_As->setEnabled(!tab->largeFileMode);
+    onEditorTextChanged();
+    onEditorUndoAvailable(tab->editor->document()->isUndoAvailable());
+    onEditorSelectionChanged();
+
+    ui->actionRead_Direction->setChecked(tab->editor->layoutDirection() == Qt::RightToLeft);
+    ui->actionFollow_Tail->setChecked(tab->followTail);
+    const bool readOnly = tab->loading ? tab->readOnlyBeforeLoading : tab->editor->isReadOnly();
+    ui->actionRead_Mode->setText(readOnly ? "打开输入法(&O)" : "关闭输入法(&L)");
+    updateWindowTitle(tab);
+}
+
+void MainWindow::updateLoadProgress()
+{
+    DocumentTab* tab = currentTab();
+    if (!loadProgress)
+        return ;
+    loadProgress->setValue(tab->loadPercent);
+    loadProgress->setVisible(tab->loading || (tab->largeFileMode && tab->loadPercent < 100));
+    loadCancelButton->setVisible(tab->loading);
+}
+
+/**
+ * @brief MainWindow::openFile
+ * 已经打开的文件切换过去，否则在新标签页中打开
+ */
 void MainWindow::openFile(QString path)
 {
-    filePath = path;
+    for (int i = 0; i < ui->tabWidget->count(); i++)
+    {
+        DocumentTab* tab = tabAt(i);
+        if (!tab->filePath.isEmpty() && QFileInfo(tab->filePath) == QFileInfo(path))
+        {
+            ui->tabWidget->setCurrentWidget(tab);
+            return ;
+        }
+    }
 
-    if (path.isEmpty())
+    if (!QFile::exists(path))
     {
-        savedContent = "";
-        fileName = "无标题";
+        qWarning() << "文件不存在";
+        return ;
     }
+    loadFile(blankTab(), path);
+}
+
+/**
+ * @brief MainWindow::openFromInstance
+ * 之后启动的进程转发过来的文件，没有文件时新建一个标签页；
+ * 窗口已关闭（隐藏）时复用留下的空白标签页
+ */
+void MainWindow::openFromInstance(const QStringList &paths)
+{
+    if (paths.isEmpty() && this->isVisible())
+        createTab();
+    for (const QString& path: paths)
+        openFile(path);
+
+    if (this->isMinimized())
+        this->showNormal();
     else
+        this->show();
+    this->raise();
+    this->activateWindow();
+    lastActiveWindow = this;
+}
+
+/**
+ * @brief MainWindow::activeInstance
+ * 转发过来的文件交给最近激活的、仍然显示着的窗口；都已关闭时用剩下的任意一个
+ */
+MainWindow *MainWindow::activeInstance()
+{
+    if (lastActiveWindow && lastActiveWindow->isVisible())
+        return lastActiveWindow;
+    MainWindow* hidden = nullptr;
+    for (QWidget* widget: QApplication::topLevelWidgets())
+    {
+        MainWindow* w = qobject_cast<MainWindow*>(widget);
+        if (w && w->isVisible())
+            return w;
+        if (w && !hidden)
+            hidden = w;
+    }
+    return hidden;
+}
+
+void MainWindow::loadFile(DocumentTab *tab, const QString &path)
+{
+    tab->fileMonitor->unwatch(); // 超大文件只读查看时不监视
+    tab->filePath = path;
+    tab->fileName = QFileInfo(path).baseName();
+    const qint64 size = QFileInfo(path).size();
+
+    // 超大文件：不载入编辑器，映射后只绘制可见的行；
+    // 查看不了（如 UTF-16）时不再整个读进编辑器，那样内存和排版都撑不住
+    if (size >= settings.value("largeFile/threshold", LARGE_FILE_THRESHOLD).toLongLong())
     {
-        QFile file(path);
-        if (!file.exists())
+        setEditorText(tab, "");
+        if (!tab->largeFileView->openFile(path))
         {
-            qWarning() << "文件不存在";
+            qWarning() << "映射文件失败" << tab->largeFileView->errorString();
+            QMessageBox::warning(this, "记事本", "无法打开 " + QFileInfo(path).fileName() + "。\n"
+                                 + tab->largeFileView->errorString());
+            tab->filePath = "";
+            tab->fileName = "无标题";
+            updateWindowTitle(tab);
             return ;
         }
-        fileName = QFileInfo(path).baseName();
+        const LineEnding lineEnding = tab->largeFileView->lineEnding();
+        setCodec(tab, tab->largeFileView->codecName(), false);
+        setLineEnding(tab, lineEnding.style(), lineEnding.isMixed());
+        setLargeFileMode(tab, true);
+        updateWindowTitle(tab);
+        StartupTrace::mark("文件已映射 " + path);
+        return ;
+    }
 
-        // 读取文件
-        if (!file.open(QIODevice::ReadOnly))
+    // 读取文件
+    if (!tab->fileLoader->open(path))
+    {
+        qWarning() << "打开文件失败";
+        tab->filePath = "";
+        tab->fileName = "无标题";
+        updateWindowTitle(tab);
+        return ;
+    }
+    setCodec(tab, tab->fileLoader->codecName(), tab->fileLoader->hasBom());
+
+    if (tab->fileLoader->size() < STREAM_OPEN_THRESHOLD)
+    {
+        setEditorText(tab, tab->fileLoader->readAll());
+        const LineEnding lineEnding = tab->fileLoader->lineEnding();
+        setLineEnding(tab, lineEnding.style(), lineEnding.isMixed());
+        tab->fileMonitor->watch(path, tab->codecName, tab->fileLoader->size());
+        tab->fileLoader->close();
+        updateWindowTitle(tab);
+        StartupTrace::mark("文件已读完 " + path);
+        return ;
+    }
+
+    // 大文件：后台分块解码，分批追加到文档末尾，加载期间只读、不记录撤销
+    tab->loading = true;
+    tab->readOnlyBeforeLoading = tab->editor->isReadOnly();
+    setEditorText(tab, "");
+    tab->editor->setReadOnly(true);
+    tab->editor->document()->setUndoRedoEnabled(false);
+    tab->loadPercent = 0;
+    if (tab == currentTab())
+    {
+        updateLoadProgress();
+        updateDeleteAction();
+    }
+    updateWindowTitle(tab);
+    tab->fileLoader->start();
+}
+
+void MainWindow::appendLoadedChunks(DocumentTab *tab)
+{
+    const QStringList chunks = tab->fileLoader->takeChunks();
+    if (chunks.isEmpty())
+        return ;
+
+    QTextCursor tc(tab->editor->document());
+    tc.movePosition(QTextCursor::End);
+    tab->textBuffer->setSuspended(true); // 解码出的文字直接交给片段表，不再从文档取回
+    tc.beginEditBlock();
+    for (const QString& chunk: chunks)
+        tc.insertText(chunk);
+    tc.endEditBlock();
+    tab->textBuffer->setSuspended(false);
+    for (const QString& chunk: chunks)
+        tab->textBuffer->append(chunk);
+    tab->editor->document()->setModified(false); // 加载中的内容不算修改
+}
+
+void MainWindow::finishLoading(DocumentTab *tab, bool cancelled)
+{
+    if (!tab->loading)
+        return ;
+    tab->loading = false;
+
+    if (!cancelled)
+    {
+        appendLoadedChunks(tab);
+        const LineEnding lineEnding = tab->fileLoader->lineEnding();
+        setLineEnding(tab, lineEnding.style(), lineEnding.isMixed());
+        tab->fileMonitor->watch(tab->filePath, tab->codecName, tab->fileLoader->size()); // 读取期间追加的部分随后补上
+    }
+    tab->fileLoader->close();
+    tab->loadPercent = 100;
+    tab->editor->document()->setUndoRedoEnabled(true);
+    tab->editor->setReadOnly(tab->readOnlyBeforeLoading);
+
+    if (cancelled) // 只读了一部分，不能当作原文件，以免保存时截断
+    {
+        tab->filePath = "";
+        tab->fileName = "无标题";
+        setCodec(tab, "UTF-8", false);
+        setLineEnding(tab, LineEnding::defaultStyle(), false);
+        setEditorText(tab, "");
+    }
+    tab->dirtyTracker->markSaved();
+    tab->journal->setSuspended(false);
+    scheduleLayout(tab);
+    if (tab == currentTab())
+    {
+        updateLoadProgress();
+        updateDeleteAction();
+    }
+    updateWindowTitle(tab);
+    if (!cancelled)
+        StartupTrace::mark("文件已读完 " + tab->filePath);
+}
+
+/**
+ * @brief MainWindow::appendFileTail
+ * 文件只是在末尾追加了内容：未修改的文档只把新增部分接到末尾，已修改的询问是否重新载入
+ */
+void MainWindow::appendFileTail(DocumentTab *tab)
+{
+    if (tab->fileSaver->isRunning()) // 保存完成后会重新开始监视
+        return ;
+    if (tab->isModified())
+    {
+        askReload(tab);
+        return ;
+    }
+    const QString text = tab->fileMonitor->readAppended();
+    if (text.isEmpty())
+        return ;
+
+    // 追加的内容作为单独的一步撤销，中间没有其他编辑时并入上一次追加，
+    // 跟随日志时撤销栈不会每次多一项，之前的撤销历史也保留
+    QTextDocument* doc = tab->editor->document();
+    QTextCursor tc(doc);
+    tc.movePosition(QTextCursor::End);
+    tab->journal->setSuspended(true);
+    tab->textBuffer->setSuspended(true);
+    if (doc->revision() == tab->tailRevision)
+        tc.joinPreviousEditBlock();
+    else
+        tc.beginEditBlock();
+    tc.insertText(text);
+    tc.endEditBlock();
+    tab->tailRevision = doc->revision();
+    tab->textBuffer->setSuspended(false);
+    tab->textBuffer->append(text);
+    tab->dirtyTracker->markSaved(tab->dirtyTracker->snapshot(false)); // 只记版本，不遍历全文计算哈希
+    tab->journal->setSuspended(false);
+    if (tab->followTail)
+    {
+        QScrollBar* bar = tab->editor->verticalScrollBar();
+        bar->setValue(bar->maximum());
+    }
+}
+
+/**
+ * @brief MainWindow::askReload
+ * 文件被改写（或已修改的文档又被追加）：询问是否重新载入，忽略则以磁盘上的现状为准继续监视
+ */
+void MainWindow::askReload(DocumentTab *tab)
+{
+    if (tab->fileSaver->isRunning())
+        return ;
+
+    QString text = tab->filePath + "\n\n此文件已被其他程序修改，是否重新载入？";
+    if (tab->isModified())
+        text += "\n你在记事本中所做的修改将丢失。";
+    ui->tabWidget->setCurrentWidget(tab);
+    QPointer<DocumentTab> guard(tab); // 询问期间标签页可能被关闭
+    int btn = QMessageBox::question(this, "记事本", text, "重新载入(&R)", "忽略(&I)");
+    if (!guard)
+        return ;
+    if (btn == 0)
+        loadFile(tab, tab->filePath);
+    else
+        tab->fileMonitor->watch(tab->filePath, tab->codecName);
+}
+
+/**
+ * @brief MainWindow::setEditorText
+ * 整体替换编辑器内容并作为未修改的状态，这期间不写恢复日志
+ */
+void MainWindow::setEditorText(DocumentTab *tab, const QString &text)
+{
+    tab->journal->setSuspended(true);
+    tab->textBuffer->setSuspended(true);
+    tab->editor->setPlainText(text);
+    tab->textBuffer->setSuspended(false);
+    tab->textBuffer->reset(text);
+    scheduleLayout(tab);
+    tab->dirtyTracker->markSaved();
+    tab->journal->setSuspended(tab->loading);
+}
+
+/**
+ * @brief MainWindow::scheduleLayout
+ * 后台标签页不排版，记下来等切换回来再排
+ */
+void MainWindow::scheduleLayout(DocumentTab *tab)
+{
+    if (tab == currentTab())
+        tab->layoutScheduler->schedule();
+    else
+        tab->layoutPending = true;
+}
+
+/**
+ * @brief MainWindow::checkRecovery
+ * 启动时检查上次异常退出留下的恢复日志
+ */
+void MainWindow::checkRecovery()
+{
+    recoveryPending = !firstPainted; // 等窗口画出来再弹出询问
+    if (recoveryPending)
+        return ;
+
+    const QStringList journals = SessionJournal::orphanedJournals();
+    if (journals.isEmpty())
+        return ;
+
+    int btn = QMessageBox::question(this, "记事本", "发现 " + QString::number(journals.size()) + " 个上次未保存的文档，是否恢复？", "恢复(&R)", "放弃(&D)", "以后再说");
+    if (btn == 2)
+        return ;
+    if (btn == 1)
+    {
+        for (const QString& journal: journals)
+            SessionJournal::remove(journal);
+        return ;
+    }
+
+    // 每个文档恢复到一个标签页，当前标签页是空的就先用它
+    for (const QString& journal: journals)
+        recoverJournal(journal);
+}
+
+/**
+ * @brief MainWindow::recoverJournal
+ * 先还原到日志开始时的内容（磁盘上的原文件或空文档），再重放之后的编辑
+ */
+bool MainWindow::recoverJournal(const QString &journalPath)
+{
+    SessionJournal::Header header;
+    QVector<SessionJournal::Record> records;
+    if (!SessionJournal::read(journalPath, &header, &records))
+        return false;
+
+    bool baseUnchanged = SessionJournal::isBaseUnchanged(header);
+    if (!baseUnchanged && (records.isEmpty() || records.first().type != SessionJournal::Record::Snapshot))
+    {
+        qWarning() << "原文件已改变，无法恢复：" << header.filePath;
+        return false;
+    }
+
+    QString base;
+    if (!header.filePath.isEmpty() && baseUnchanged)
+    {
+        FileLoader loader;
+        if (loader.open(header.filePath))
+            base = loader.readAll();
+    }
+    DocumentTab* tab = blankTab();
+    tab->filePath = header.filePath;
+    tab->fileName = tab->filePath.isEmpty() ? "无标题" : QFileInfo(tab->filePath).baseName();
+    setCodec(tab, header.codec, header.bom);
+    setLineEnding(tab, static_cast<LineEnding::Style>(header.lineStyle), false);
+    setEditorText(tab, base);
+    if (!tab->filePath.isEmpty())
+        tab->fileMonitor->watch(tab->filePath, tab->codecName);
+    SessionJournal::replay(records, tab->editor->document());
+    SessionJournal::remove(journalPath);
+    updateWindowTitle(tab);
+    return true;
+}
+
+bool MainWindow::isModified() const
+{
+    for (int i = 0; i < ui->tabWidget->count(); i++)
+        if (tabAt(i)->isModified())
+            return true;
+    return false;
+}
+
+/**
+ * @brief MainWindow::askSave
+ * @return 是否继续
+ */
+bool MainWindow::askSave(DocumentTab *tab)
+{
+    waitForSave(tab);
+    if (!tab->isModified())
+        return true;
+
+    // 有未保存的更改
+    ui->tabWidget->setCurrentWidget(tab);
+    int btn = QMessageBox::question(this, "记事本", "你想更改保存到 " + (tab->fileName.isEmpty() ? "无标题" : tab->fileName) + " 吗？", "保存(&S)", "不保存(&N)", "取消");
+    if (btn == 2) // 取消
+        return false;
+    if (btn == 0) // 保存
+    {
+        if (!save(tab))
+            return false;
+        waitForSave(tab);
+        return !tab->isModified(); // 保存失败则不继续
+    }
+    return true;
+}
+
+/**
+ * @brief MainWindow::waitForSave
+ * 等待后台保存（包括合并的那一次）全部完成
+ */
+void MainWindow::waitForSave(DocumentTab *tab)
+{
+    while (tab->fileSaver->isRunning())
+        tab->fileSaver->waitForFinished();
+}
+
+/**
+ * @brief MainWindow::updateWindowTitle
+ * 标签页上显示文件名，窗口标题跟随当前标签页
+ */
+void MainWindow::updateWindowTitle(DocumentTab *tab)
+{
+    const QString title = (tab->isModified() ? "*" : "") + tab->fileName;
+    const int index = ui->tabWidget->indexOf(tab);
+    ui->tabWidget->setTabText(index, title);
+    ui->tabWidget->setTabToolTip(index, tab->filePath);
+    if (tab == currentTab())
+        this->setWindowTitle(title + " - 记事本");
+}
+
+void MainWindow::createFindDialog()
+{
+    findDialog = new FindDialog(settings, this);
+
+    connect(findDialog, &FindDialog::signalShow, this, [=]{
+        ui->actionFind_Next_N->setEnabled(true);
+        ui->actionFind_Prev_V->setEnabled(true);
+        updateSearchPattern();
+    });
+    connect(findDialog, &FindDialog::signalHide, this, [=]{
+        ui->actionFind_Next_N->setEnabled(false);
+        ui->actionFind_Prev_V->setEnabled(false);
+        searchPatternTimer.stop();
+        currentTab()->searchEngine->clear();
+        updateSearchHighlights();
+    });
+    connect(findDialog, &FindDialog::signalPatternChanged, this, [=]{
+        searchPatternTimer.start();
+    });
+
+    connect(findDialog, &FindDialog::signalFindNext, this, &MainWindow::on_actionFind_Next_N_triggered);
+    connect(findDialog, &FindDialog::signalFindPrev, this, &MainWindow::on_actionFind_Prev_V_triggered);
+    connect(findDialog, &FindDialog::signalReplaceNext, this, &MainWindow::replaceNext);
+    connect(findDialog, &FindDialog::signalReplaceAll, this, [=]{
+        const QString& findText = findDialog->getFindText();
+        const QString& replaceText = findDialog->getReplaceText();
+        DocumentTab* tab = currentTab();
+        if (findText.isEmpty() || tab->largeFileMode)
+            return ;
+
+        updateSearchPattern();
+        const int count = replaceAll(tab, replaceText);
+        if (count < 0)
+            return ;
+        if (count == 0)
         {
-            qWarning() << "打开文件失败";
+            findDialog->setMatchInfo(0, 0);
             return ;
         }
-        savedContent = QString::fromLocal8Bit(file.readAll());
+        qInfo() << "全部替换：" << findText << "->" << replaceText << count;
+        findDialog->setMessage("已替换 " + QString::number(count) + " 处");
+    });
+}
+
+/**
+ * @brief MainWindow::replaceNext
+ * 替换 逻辑上分为：查找、选中、替换
+ * 选中的是否为匹配，与查找、全部替换使用同样的匹配规则
+ */
+void MainWindow::replaceNext()
+{
+    const QString& findText = findDialog->getFindText();
+    const QString& replaceText = findDialog->getReplaceText();
+    DocumentTab* tab = currentTab();
+    if (findText.isEmpty() || tab->largeFileMode)
+        return ;
+
+    updateSearchPattern();
+    SearchEngine* engine = tab->searchEngine;
+    if (!engine->isPatternValid())
+        return ;
+    if (!engine->isReady() && engine->isRegex())
+    {
+        queuedFind = QueuedReplaceNext;
+        return ;
+    }
+    QTextCursor tc = tab->editor->textCursor();
+    const bool selected = engine->isReady() ? engine->matchIndex(tc.selectionStart(), tc.selectionEnd()) >= 0
+                                            : engine->isMatch(tc.selectionStart(), tc.selectionEnd());
+    if (!selected)
+    {
+        // 如果选中的词不是findText，则查找下一个
+        on_actionFind_Next_N_triggered();
+        qInfo() << "查找：" << findText;
+    }
+    else
+    {
+        // 已选中，则替换选中的；正则表达式展开其中的捕获组
+        tc.insertText(engine->replacementFor(tc.selectionStart(), tc.selectionEnd(), replaceText));
+        tab->editor->setTextCursor(tc);
+        qInfo() << "替换：" << findText << "->" << replaceText;
+        on_actionFind_Next_N_triggered(); // 查找下一个
+    }
+}
+
+/**
+ * @brief MainWindow::runQueuedFind
+ * 正则表达式扫描完成后执行等待中的查找或替换
+ */
+void MainWindow::runQueuedFind()
+{
+    if (queuedFind == NoQueuedFind || !currentTab()->searchEngine->isReady())
+        return ;
+    const QueuedFind queued = queuedFind;
+    queuedFind = NoQueuedFind;
+    if (queued == QueuedReplaceNext)
+        replaceNext();
+    else
+        findMatch(queued == QueuedFindPrev);
+}
+
+/**
+ * @brief MainWindow::replaceAll
+ * 先取得全部匹配（去掉相互重叠的），再在一个编辑块里从后往前替换，只改动匹配所在的段落
+ * @return 替换的个数，表达式有误时为 -1
+ */
+int MainWindow::replaceAll(DocumentTab *tab, const QString &replaceText)
+{
+    SearchEngine* engine = tab->searchEngine;
+    engine->waitForFinished();
+    if (!engine->isPatternValid())
+        return -1;
+    QVector<QPair<int, int>> ranges;
+    ranges.reserve(engine->count());
+    int end = 0;
+    for (int i = 0; i < engine->count(); i++)
+    {
+        if (engine->matchAt(i) < end)
+            continue;
+        end = engine->matchAt(i) + engine->matchLength(i);
+        ranges.append(qMakePair(engine->matchAt(i), end));
+    }
+    if (ranges.isEmpty())
+        return 0;
+
+    // 正则表达式的替换文本要按改动前的前后文展开捕获组，先全部算好
+    QStringList texts;
+    if (engine->isRegex())
+    {
+        texts.reserve(ranges.size());
+        for (const QPair<int, int>& range: ranges)
+            texts.append(engine->replacementFor(range.first, range.second, replaceText));
+    }
+
+    QTextCursor tc(tab->editor->document());
+    tc.beginEditBlock();
+    for (int i = ranges.size() - 1; i >= 0; i--)
+    {
+        tc.setPosition(ranges.at(i).first);
+        tc.setPosition(ranges.at(i).second, QTextCursor::KeepAnchor);
+        tc.insertText(texts.isEmpty() ? replaceText : texts.at(i));
     }
-    ui->plainTextEdit->setPlainText(savedContent);
-    updateWindowTitle();
+    tc.endEditBlock(); // 整体作为一步撤销
+    return ranges.size();
 }
 
-bool MainWindow::isModified() const
+/**
+ * @brief MainWindow::setLargeFileMode
+ * 切换超大文件只读查看模式，此时不能编辑和保存
+ */
+void MainWindow::setLargeFileMode(DocumentTab *tab, bool enable)
 {
-    return ui->plainTextEdit->toPlainText() != savedContent;
+    tab->setLargeFileMode(enable);
+    if (tab == currentTab())
+        syncCurrentTab();
 }
 
 /**
- * @brief MainWindow::askSave
- * @return 是否继续
+ * @brief MainWindow::setCodec
+ * 记录打开时检测到的编码，保存时原样写回
  */
-bool MainWindow::askSave()
+void MainWindow::setCodec(DocumentTab *tab, const QByteArray &name, bool bom)
 {
-    if (!isModified())
-        return true;
+    tab->codecName = name;
+    tab->codecBom = bom;
+    if (tab == currentTab() && codecLabel)
+        codecLabel->setText(bom ? "带有 BOM 的 " + QString(name) : QString(name));
+    tab->journal->setHeader(tab->filePath, tab->codecName, tab->codecBom, tab->lineStyle);
+}
 
-    // 有未保存的更改
-    int btn = QMessageBox::question(this, "记事本", "你想更改保存到 " + (fileName.isEmpty() ? "无标题" : fileName) + " 吗？", "保存(&S)", "不保存(&N)", "取消");
-    if (btn == 2) // 取消
-        return false;
-    if (btn == 0) // 保存
-    {
-        return on_actionSave_triggered();
-    }
-    return true;
+/**
+ * @brief MainWindow::setLineEnding
+ * 混合换行的文件按出现最多的一种保存
+ */
+void MainWindow::setLineEnding(DocumentTab *tab, LineEnding::Style style, bool mixed)
+{
+    tab->lineStyle = style;
+    tab->lineMixed = mixed;
+    if (tab == currentTab() && lineLabel)
+        lineLabel->setText(LineEnding::label(style) + (mixed ? "，混合" : ""));
+    tab->journal->setHeader(tab->filePath, tab->codecName, tab->codecBom, tab->lineStyle);
 }
 
-void MainWindow::updateWindowTitle()
+void MainWindow::showEvent(QShowEvent *e)
 {
-    this->setWindowTitle((isModified() ? "*" : "") + fileName + " - 记事本");
+    this->restoreGeometry(settings.value("mainwindow/geometry").toByteArray());
+    this->restoreState(settings.value("mainwindow/state").toByteArray());
+
+    QMainWindow::showEvent(e);
 }
 
-void MainWindow::createFindDialog()
+/**
+ * @brief MainWindow::changeEvent
+ * 记住最近激活的窗口；切到查找框等子窗口时不变
+ */
+void MainWindow::changeEvent(QEvent *e)
 {
-    findDialog = new FindDialog(settings, this);
+    if (e->type() == QEvent::ActivationChange && this->isActiveWindow())
+        lastActiveWindow = this;
+    QMainWindow::changeEvent(e);
+}
 
-    connect(findDialog, &FindDialog::signalShow, this, [=]{
-        ui->actionFind_Next_N->setEnabled(true);
-        ui->actionFind_Prev_V->setEnabled(true);
-    });
-    connect(findDialog, &FindDialog::signalHide, this, [=]{
-        ui->actionFind_Next_N->setEnabled(false);
-        ui->actionFind_Prev_V->setEnabled(false);
-    });
-    /* connect(findDialog, &FindDialog::signalTextChanged, this, [=](const QString& text){
-        this->findText = text;
-    }); */
-    connect(findDialog, &FindDialog::signalFindNext, this, &MainWindow::on_actionFind_Next_N_triggered);
-    connect(findDialog, &FindDialog::signalFindPrev, this, &MainWindow::on_actionFind_Prev_V_triggered);
-    connect(findDialog, &FindDialog::signalReplaceNext, this, [=]{
-        const QString& findText = findDialog->getFindText();
-        const QString& replaceText = findDialog->getReplaceText();
-        if (findText.isEmpty())
-            return ;
+/**
+ * @brief MainWindow::eventFilter
+ * 窗口第一次绘制后开始延后的初始化；
+ * 自动换行时编辑区宽度变化会清空排版，同样交给空闲排版
+ */
+bool MainWindow::eventFilter(QObject *obj, QEvent *e)
+{
+    if (obj == this && e->type() == QEvent::Paint)
+    {
+        StartupTrace::mark("首次绘制");
+        firstPainted = true;
+        this->removeEventFilter(this);
+        QTimer::singleShot(0, this, &MainWindow::initDeferred);
+        return QMainWindow::eventFilter(obj, e);
+    }
 
-        // 替换 逻辑上分为：查找、选中、替换
-        const QString& selectedText = ui->plainTextEdit->textCursor().selectedText();
-        if ((findDialog->isCaseSensitive() && selectedText != findText)
-                || selectedText.toLower() != findText.toLower())
+    QPlainTextEdit* edit = qobject_cast<QPlainTextEdit*>(obj->parent());
+    DocumentTab* tab = edit ? qobject_cast<DocumentTab*>(edit->parentWidget()) : nullptr;
+    if (!tab || obj != tab->editor->viewport())
+        return QMainWindow::eventFilter(obj, e);
+
+    if (e->type() == QEvent::Resize && edit->wordWrapMode() != QTextOption::NoWrap)
+    {
+        QResizeEvent* re = static_cast<QResizeEvent*>(e);
+        if (re->size().width() != re->oldSize().width())
+            scheduleLayout(tab);
+    }
+    else if (e->type() == QEvent::Wheel && static_cast<QWheelEvent*>(e)->modifiers() & Qt::ControlModifier)
+    {
+        // Ctrl+滚轮按百分比缩放，代替 QPlainTextEdit 自带的按字号缩放；触控板的小步进累积起来
+        wheelZoomDelta += static_cast<QWheelEvent*>(e)->angleDelta().y();
+        const int steps = wheelZoomDelta / 120;
+        wheelZoomDelta %= 120;
+        if (steps)
+            setZoom(tab->zoomSize + steps * 10);
+        return true;
+    }
+    else if (e->type() == QEvent::Gesture)
+    {
+        QGestureEvent* ge = static_cast<QGestureEvent*>(e);
+        if (QPinchGesture* pinch = static_cast<QPinchGesture*>(ge->gesture(Qt::PinchGesture)))
         {
-            // 如果选中的词不是findText，则查找下一个
-            on_actionFind_Next_N_triggered();
-            qInfo() << "查找：" << findText;
+            if (pinch->state() == Qt::GestureStarted)
+                pinchStartZoom = tab->zoomSize;
+            if (pinch->changeFlags() & QPinchGesture::ScaleFactorChanged)
+                setZoom(qRound(pinchStartZoom * pinch->totalScaleFactor()));
+            ge->accept(pinch);
+            return true;
         }
-        else
+    }
+    else if (e->type() == QEvent::NativeGesture)
+    {
+        QNativeGestureEvent* ne = static_cast<QNativeGestureEvent*>(e);
+        if (ne->gestureType() == Qt::ZoomNativeGesture)
         {
-            // 已选中，则替换选中的
-            QTextCursor tc = ui->plainTextEdit->textCursor();
-            tc.insertText(replaceText);
-            ui->plainTextEdit->setTextCursor(tc);
-            qInfo() << "替换：" << findText << "->" << replaceText;
-            on_actionFind_Next_N_triggered(); // 查找下一个
+            setZoom(qRound(tab->zoomSize * (1 + ne->value())));
+            return true;
         }
-    });
-    connect(findDialog, &FindDialog::signalReplaceAll, this, [=]{
-        const QString& findText = findDialog->getFindText();
-        const QString& replaceText = findDialog->getReplaceText();
-        if (findText.isEmpty())
-            return ;
-        qInfo() << "全部替换：" << findText << "->" << replaceText;
-
-        QString content = ui->plainTextEdit->toPlainText();
-        QTextCursor tc = ui->plainTextEdit->textCursor();
-        tc.setPosition(0);
-        tc.setPosition(content.length(), QTextCursor::KeepAnchor);
-        content.replace(findText, replaceText);
-        tc.insertText(content);
-        // ui->plainTextEdit->setTextCursor(tc);     // 不调用这句话，保留替换之前的位置
-        // ui->plainTextEdit->setPlainText(content); // 这个会导致无法撤销，而且会重置光标位置到开头
-    });
-}
-
-void MainWindow::showEvent(QShowEvent *e)
-{
-    this->restoreGeometry(settings.value("mainwindow/geometry").toByteArray());
-    this->restoreState(settings.value("mainwindow/state").toByteArray());
-
-    QMainWindow::showEvent(e);
+    }
+    return QMainWindow::eventFilter(obj, e);
 }
 
 void MainWindow::closeEvent(QCloseEvent *e)
 {
-    if (!askSave())
+    for (int i = 0; i < ui->tabWidget->count(); i++)
     {
-        e->ignore();
-        return ;
+        DocumentTab* tab = tabAt(i);
+        if (tab->loading)
+        {
+            tab->fileLoader->cancel();
+            finishLoading(tab, true);
+        }
+        if (!askSave(tab))
+        {
+            e->ignore();
+            return ;
+        }
     }
+    for (int i = 0; i < ui->tabWidget->count(); i++)
+        tabAt(i)->journal->discard(); // 已保存或选择了不保存
     settings.setValue("mainwindow/geometry", this->saveGeometry());
     settings.setValue("mainwindow/state", this->saveState());
+    settings.sync();
 
     QMainWindow::closeEvent(e);
 }
 
-void MainWindow::on_plainTextEdit_textChanged()
+void MainWindow::onEditorTextChanged()
 {
-    if (fileName.isEmpty())
-        fileName = "无标题";
-    updateWindowTitle();
+    DocumentTab* tab = currentTab();
+    if (tab->fileName.isEmpty())
+    {
+        tab->fileName = "无标题";
+        updateWindowTitle(tab);
+    }
+
+    // 超大文件模式下编辑器是空的，但可以在查看器中查找
+    bool empty = tab->editor->document()->isEmpty();
+    bool searchable = !empty || tab->largeFileMode;
+    ui->actionFind_F->setEnabled(searchable);
+    ui->actionReplace_R->setEnabled(!empty && !tab->largeFileMode);
+    ui->actionFind_Next_N->setEnabled(searchable && findDialog && findDialog->isVisible());
+    ui->actionFind_Prev_V->setEnabled(searchable && findDialog && findDialog->isVisible());
+}
 
-    bool empty = ui->plainTextEdit->toPlainText().isEmpty();
-    ui->actionFind_F->setEnabled(!empty);
-    ui->actionReplace_R->setEnabled(!empty);
-    ui->actionFind_Next_N->setEnabled(!empty && findDialog && findDialog->isVisible());
-    ui->actionFind_Prev_V->setEnabled(!empty && findDialog && findDialog->isVisible());
+void MainWindow::onEditorCursorPositionChanged()
+{
+    scheduleStatusBar();
 }
 
-void MainWindow::on_plainTextEdit_cursorPositionChanged()
+void MainWindow::scheduleStatusBar()
 {
-    QTextCursor tc = ui->plainTextEdit->textCursor();
+    if (!statusTimer.isActive())
+        statusTimer.start();
+}
 
-    QTextLayout* ly = tc.block().layout();
-    int posInBlock = tc.position() - tc.block().position(); // 当前光标在block内的相对位置
-    int line = ly->lineForTextPosition(posInBlock).lineNumber() + tc.block().firstLineNumber();
+/**
+ * @brief MainWindow::updateStatusBar
+ * 行列、选中长度、字符数都不需要遍历文档；数字没变就不重新生成文字
+ */
+void MainWindow::updateStatusBar()
+{
+    DocumentTab* tab = currentTab();
+    if (!tab || tab->largeFileMode || !posLabel)
+        return ;
 
-    int col = tc.columnNumber(); // 第几列
+    QTextCursor tc = tab->editor->textCursor();
+    const int line = visualLineNumber(tab, tc);
+    const int col = tc.columnNumber(); // 第几列
     // int row = tc.blockNumber(); // 第几段，无法识别WordWrap的第几行
-    posLabel->setText("第 " + QString::number(line + 1) + " 行，第 " + QString::number(col + 1) + " 列");
+    if (line != shownLine || col != shownColumn)
+    {
+        shownLine = line;
+        shownColumn = col;
+        posLabel->setText(QString("第 %1 行，第 %2 列").arg(line + 1).arg(col + 1));
+    }
+
+    const int selected = tc.selectionEnd() - tc.selectionStart();
+    const int chars = tab->editor->document()->characterCount() - 1;
+    if (selected != shownSelection || chars != shownChars)
+    {
+        shownSelection = selected;
+        shownChars = chars;
+        if (selected)
+            charLabel->setText(QString("已选择 %1 / %2 个字符").arg(selected).arg(chars));
+        else
+            charLabel->setText(QString("%1 个字符").arg(chars));
+    }
+}
+
+/**
+ * @brief MainWindow::visualLineNumber
+ * 自动换行后光标所在的显示行，从0开始；
+ * 记住上一次所在段落的起始显示行，在同一段内移动时不再查询
+ */
+int MainWindow::visualLineNumber(DocumentTab *tab, const QTextCursor &tc)
+{
+    const QTextBlock block = tc.block();
+    const int revision = tab->editor->document()->revision();
+    if (block.blockNumber() != tab->lineCacheBlock || revision != tab->lineCacheRevision)
+    {
+        tab->lineCacheBlock = block.blockNumber();
+        tab->lineCacheRevision = revision;
+        tab->lineCacheFirstLine = block.firstLineNumber();
+    }
+
+    QTextLayout* ly = block.layout();
+    int posInBlock = tc.position() - block.position(); // 当前光标在block内的相对位置
+    return ly->lineForTextPosition(posInBlock).lineNumber() + tab->lineCacheFirstLine;
 }
 
-void MainWindow::on_plainTextEdit_undoAvailable(bool b)
+void MainWindow::onEditorUndoAvailable(bool b)
 {
     ui->actionUndo_U->setEnabled(b);
 }
 
-void MainWindow::on_plainTextEdit_selectionChanged()
+void MainWindow::onEditorSelectionChanged()
 {
-    bool selected = ui->plainTextEdit->textCursor().hasSelection();
+    bool selected = currentTab()->editor->textCursor().hasSelection();
     ui->actionSearch_By_Bing->setEnabled(selected);
     ui->actionCut_T->setEnabled(selected);
     ui->actionCopy_C->setEnabled(selected);
-    ui->actionDelete_L->setEnabled(selected);
     ui->actionReselect_Chinese->setEnabled(selected);
+    updateDeleteAction();
+    scheduleStatusBar();
 }
 
-void MainWindow::on_actionNew_triggered()
+/**
+ * @brief MainWindow::updateDeleteAction
+ * 删除在可编辑时都可用：没有选中时删除光标后的一个字，
+ * 超大文件查看、只读时禁用，Del 键交还给当前的控件
+ */
+void MainWindow::updateDeleteAction()
 {
-    if (!askSave())
-        return ;
+    DocumentTab* tab = currentTab();
+    ui->actionDelete_L->setEnabled(!tab->largeFileMode && !tab->editor->isReadOnly());
+}
 
-    openFile("");
+void MainWindow::on_actionNew_triggered()
+{
+    createTab();
 }
 
+/**
+ * @brief MainWindow::on_actionNew_Window_triggered
+ * 新窗口在同一进程中创建，不再启动新的进程
+ */
 void MainWindow::on_actionNew_Window_triggered()
 {
-    QProcess p(this);
-    p.startDetached(QApplication::applicationFilePath(), {"-new"});
+    MainWindow* w = new MainWindow;
+    w->setAttribute(Qt::WA_DeleteOnClose);
+    w->show();
 }
 
 void MainWindow::on_actionOpen_triggered()
 {
-    if (!askSave())
-        return ;
-
     QString recentPath = settings.value("recent/filePath").toString();
     QString path = QFileDialog::getOpenFileName(this, "打开", recentPath, "*.txt");
     if (path.isEmpty())
@@ -272,162 +1241,253 @@ void MainWindow::on_actionOpen_triggered()
 
 bool MainWindow::on_actionSave_triggered()
 {
-    if (filePath.isEmpty()) // 没有路径，另存为
+    return save(currentTab());
+}
+
+bool MainWindow::save(DocumentTab *tab)
+{
+    if (tab->loading || tab->largeFileMode) // 还没读完，或只读查看
+        return false;
+
+    if (tab->filePath.isEmpty()) // 没有路径，另存为
     {
         QString recentPath = settings.value("recent/filePath").toString();
         QString path = QFileDialog::getSaveFileName(this, "另存为", recentPath, "*.txt");
         if (path.isEmpty())
             return false;
         settings.setValue("recent/filePath", path);
-        filePath = path;
-        fileName = QFileInfo(path).baseName();
+        tab->filePath = path;
+        tab->fileName = QFileInfo(path).baseName();
     }
 
-    // 写出文件
-    QFile file(filePath);
-    if (!file.open(QIODevice::WriteOnly))
+    // 上一次保存还没完成，合并到完成之后再保存一次
+    if (tab->fileSaver->isRunning())
     {
-        qWarning() << "打开文件失败";
-        return false;
+        tab->savePending = true;
+        return true;
     }
-    QTextStream ts(&file);
-    ts.setCodec("GBK");
-    savedContent = ui->plainTextEdit->toPlainText();
-    ts << savedContent;
-    file.close();
-    qInfo() << "save:" << filePath << savedContent.length();
-    updateWindowTitle();
+    startSave(tab);
     return true;
 }
 
+/**
+ * @brief MainWindow::startSave
+ * 界面线程只取快照，编码和写入在后台进行
+ */
+void MainWindow::startSave(DocumentTab *tab)
+{
+    tab->savePending = false;
+    tab->savingSnapshot = tab->dirtyTracker->snapshot(false); // 哈希由保存线程计算
+    tab->fileSaver->save(tab->filePath, tab->textBuffer->text(), tab->codecName, tab->codecBom, tab->lineStyle);
+}
+
+void MainWindow::finishSave(DocumentTab *tab, bool ok, const QString &path, const QString &error)
+{
+    // 保存本身引起的变化不算外部修改，以保存后的文件为准重新监视
+    if (!tab->filePath.isEmpty())
+        tab->fileMonitor->watch(tab->filePath, tab->codecName);
+    if (!ok)
+    {
+        qWarning() << "保存文件失败" << path << error;
+        ui->statusbar->showMessage("保存失败：" + error, 5000);
+        tab->savePending = false;
+        return ;
+    }
+
+    qInfo() << "save:" << path << tab->savingSnapshot.length;
+    if (path == tab->filePath)
+        tab->dirtyTracker->markSaved(tab->savingSnapshot);
+    tab->journal->setHeader(tab->filePath, tab->codecName, tab->codecBom, tab->lineStyle);
+    if (tab->isModified()) // 保存期间又有编辑，磁盘上的文件已变，日志改为完整快照
+        tab->journal->compact();
+    updateWindowTitle(tab);
+    if (tab->savePending)
+        startSave(tab);
+}
+
 bool MainWindow::on_actionSave_As_triggered()
 {
-    QString temp = filePath;
-    filePath = "";
-    if (!on_actionSave_triggered()) // 直接调用保存的
-        filePath = temp;
+    DocumentTab* tab = currentTab();
+    QString temp = tab->filePath;
+    tab->filePath = "";
+    if (!save(tab)) // 直接调用保存的
+        tab->filePath = temp;
     return true;
 }
 
-void MainWindow::on_actionExit_triggered()
+void MainWindow::on_actionClose_Tab_triggered()
 {
-    if (!askSave())
-        return ;
+    closeTab(currentTab());
+}
 
-    this->close();
+void MainWindow::on_actionExit_triggered()
+{
+    this->close(); // 在 closeEvent 中逐个询问保存
 }
 
 void MainWindow::on_actionUndo_U_triggered()
 {
-    ui->plainTextEdit->undo();
+    currentTab()->editor->undo();
 }
 
 void MainWindow::on_actionCut_T_triggered()
 {
-    ui->plainTextEdit->cut();
+    currentTab()->editor->cut();
 }
 
 void MainWindow::on_actionCopy_C_triggered()
 {
-    ui->plainTextEdit->copy();
+    currentTab()->editor->copy();
 }
 
 void MainWindow::on_actionPaste_P_triggered()
 {
-    ui->plainTextEdit->paste();
+    currentTab()->editor->paste();
 }
 
+/**
+ * @brief MainWindow::on_actionDelete_L_triggered
+ * 有选中时删除选中的；否则删除光标后的一个字（按字素，不拆开代理对和组合字符），
+ * 只查看光标所在的段落，与文件大小无关
+ */
 void MainWindow::on_actionDelete_L_triggered()
 {
-    QTextCursor tc = ui->plainTextEdit->textCursor();
-    int pos = tc.position();
-    if (pos >= ui->plainTextEdit->toPlainText().length())
+    DocumentTab* tab = currentTab();
+    QPlainTextEdit* edit = tab->editor;
+    if (tab->largeFileMode || edit->isReadOnly())
+        return ;
+    QTextCursor tc = edit->textCursor();
+    if (tc.hasSelection())
+    {
+        tc.removeSelectedText();
+        return ;
+    }
+    if (tc.atEnd())
         return ;
-    tc.setPosition(pos + 1, QTextCursor::MoveMode::KeepAnchor);
+
+    const QTextBlock block = tc.block();
+    const int posInBlock = tc.position() - block.position();
+    int next = posInBlock + 1; // 段落末尾：删除换行
+    if (posInBlock < block.length() - 1)
+    {
+        QTextBoundaryFinder finder(QTextBoundaryFinder::Grapheme, block.text());
+        finder.setPosition(posInBlock);
+        next = finder.toNextBoundary();
+        if (next < 0)
+            next = block.length() - 1;
+    }
+    tc.setPosition(block.position() + next, QTextCursor::KeepAnchor);
     tc.removeSelectedText();
+    edit->setTextCursor(tc);
 }
 
 void MainWindow::on_actionSearch_By_Bing_triggered()
 {
-    // !这里是转到UTF-8，保存到txt是保存为GBK
-    QByteArray key = ui->plainTextEdit->textCursor().selectedText().toUtf8().toPercentEncoding();
+    // 搜索关键词统一转为 UTF-8，与文件保存的编码无关
+    QByteArray key = currentTab()->editor->textCursor().selectedText().toUtf8().toPercentEncoding();
     QDesktopServices::openUrl(QUrl("https://cn.bing.com/search?q=" + key + "&form=NPCTXT"));
 }
 
 
 void MainWindow::on_actionSelect_All_A_triggered()
 {
-    ui->plainTextEdit->selectAll();
+    currentTab()->editor->selectAll();
 }
 
 void MainWindow::on_actionTime_Date_D_triggered()
 {
-    ui->plainTextEdit->insertPlainText(QDateTime::currentDateTime().toString("hh:mm yyyy/MM/dd"));
+    currentTab()->editor->insertPlainText(QDateTime::currentDateTime().toString("hh:mm yyyy/MM/dd"));
 }
 
 void MainWindow::on_actionWord_Wrap_W_triggered()
 {
-    if (ui->plainTextEdit->wordWrapMode() == QTextOption::NoWrap)
-    {
-        ui->plainTextEdit->setWordWrapMode(QTextOption::WordWrap);
-        ui->actionWord_Wrap_W->setChecked(true);
-        settings.setValue("wordWrap", true);
-    }
-    else
+    bool wrap = ui->actionWord_Wrap_W->isChecked();
+    for (int i = 0; i < ui->tabWidget->count(); i++)
     {
-        ui->plainTextEdit->setWordWrapMode(QTextOption::NoWrap);
-        ui->actionWord_Wrap_W->setChecked(false);
-        settings.setValue("wordWrap", false);
+        DocumentTab* tab = tabAt(i);
+        tab->editor->setWordWrapMode(wrap ? QTextOption::WordWrap : QTextOption::NoWrap);
+        scheduleLayout(tab);
     }
+    settings.setValue("wordWrap", wrap);
 }
 
 void MainWindow::on_actionFont_F_triggered()
 {
     bool ok;
-    QFont f = QFontDialog::getFont(&ok, ui->plainTextEdit->font(), this, "字体");
+    QFont f = QFontDialog::getFont(&ok, baseFont, this, "字体");
     if (!ok)
         return ;
 
-    ui->plainTextEdit->setFont(f);
+    baseFont = f;
+    zoomFonts.clear();
+    for (int i = 0; i < ui->tabWidget->count(); i++)
+        applyZoom(tabAt(i));
     settings.setValue("font", f.toString());
 }
 
 void MainWindow::on_actionZoom_In_I_triggered()
 {
-    if (zoomSize >= 500)
-        return ;
-
-    ui->plainTextEdit->zoomIn(1);
-    zoomSize += 10;
-    zoomLabel->setText(QString::number(zoomSize) + "%");
+    setZoom(currentTab()->zoomSize + 10);
 }
 
 void MainWindow::on_actionZoom_Out_O_triggered()
 {
-    if (zoomSize <= 10)
-        return ;
-
-    ui->plainTextEdit->zoomOut(1);
-    zoomSize -= 10;
-    zoomLabel->setText(QString::number(zoomSize) + "%");
+    setZoom(currentTab()->zoomSize - 10);
 }
 
 void MainWindow::on_actionZoom_Default_triggered()
 {
-    QString fs;
-    if (!(fs = settings.value("font").toString()).isEmpty())
+    setZoom(100);
+}
+
+/**
+ * @brief MainWindow::setZoom
+ * 缩放当前标签页；比例立即显示，字体稍后统一应用
+ */
+void MainWindow::setZoom(int percent)
+{
+    DocumentTab* tab = currentTab();
+    percent = qBound(10, percent, 500);
+    if (percent == tab->zoomSize)
+        return ;
+    tab->zoomSize = percent;
+    if (zoomLabel)
+        zoomLabel->setText(QString::number(tab->zoomSize) + "%");
+    zoomTimer.start();
+}
+
+/**
+ * @brief MainWindow::applyZoom
+ * 每个比例的字体只创建一次，各标签页共用
+ */
+void MainWindow::applyZoom(DocumentTab *tab)
+{
+    auto it = zoomFonts.constFind(tab->zoomSize);
+    if (it == zoomFonts.constEnd())
     {
-        QFont f;
-        f.fromString(fs);
-        ui->plainTextEdit->setFont(f);
+        QFont f = baseFont;
+        if (baseFont.pointSizeF() > 0)
+            f.setPointSizeF(baseFont.pointSizeF() * tab->zoomSize / 100);
+        else
+            f.setPixelSize(qMax(1, baseFont.pixelSize() * tab->zoomSize / 100));
+        it = zoomFonts.insert(tab->zoomSize, f);
     }
-    else
+    if (tab->editor->font() == it.value())
+        return ;
+    tab->editor->setFont(it.value());
+    tab->largeFileView->setFont(it.value());
+    scheduleLayout(tab);
+}
+
+void MainWindow::on_actionFollow_Tail_triggered()
+{
+    DocumentTab* tab = currentTab();
+    tab->followTail = ui->actionFollow_Tail->isChecked();
+    if (tab->followTail)
     {
-        ui->plainTextEdit->setFont(qApp->font());
+        QScrollBar* bar = tab->editor->verticalScrollBar();
+        bar->setValue(bar->maximum());
     }
-
-    zoomSize = 100;
-    zoomLabel->setText(QString::number(zoomSize) + "%");
 }
 
 void MainWindow::on_actionStatus_Bar_S_triggered()
@@ -466,19 +1526,13 @@ void MainWindow::on_actionFind_Next_N_triggered()
     if (text.isEmpty())
         return ;
 
-    QTextDocument::FindFlags flags;
-    if (findDialog->isCaseSensitive())
-        flags |= QTextDocument::FindCaseSensitively;
-    bool rst = ui->plainTextEdit->find(text, flags);
-    if (!rst && findDialog->isLoop()
-            && ui->plainTextEdit->toPlainText().contains(text)) // 没找到，尝试从头开始
+    DocumentTab* tab = currentTab();
+    if (tab->largeFileMode)
     {
-        qInfo() << "从开头查找";
-        QTextCursor tc = ui->plainTextEdit->textCursor();
-        tc.setPosition(0);
-        ui->plainTextEdit->setTextCursor(tc);
-        on_actionFind_Next_N_triggered();
+        tab->largeFileView->find(text, findDialog->isCaseSensitive(), false, findDialog->isLoop());
+        return ;
     }
+    findMatch(false);
 }
 
 void MainWindow::on_actionFind_Prev_V_triggered()
@@ -487,21 +1541,142 @@ void MainWindow::on_actionFind_Prev_V_triggered()
     if (text.isEmpty())
         return ;
 
-    QTextDocument::FindFlags flags = QTextDocument::FindBackward;
-    if (findDialog->isCaseSensitive())
-        flags |= QTextDocument::FindCaseSensitively;
-    bool rst = ui->plainTextEdit->find(text, flags);
-    if (!rst && findDialog->isLoop()
-            && ui->plainTextEdit->toPlainText().contains(text))
+    DocumentTab* tab = currentTab();
+    if (tab->largeFileMode)
+    {
+        tab->largeFileView->find(text, findDialog->isCaseSensitive(), true, findDialog->isLoop());
+        return ;
+    }
+    findMatch(true);
+}
+
+/**
+ * @brief MainWindow::updateSearchPattern
+ * 把查找框的内容交给当前标签页的查找引擎统计
+ */
+void MainWindow::updateSearchPattern()
+{
+    searchPatternTimer.stop();
+    DocumentTab* tab = currentTab();
+    if (!tab || tab->largeFileMode)
+        return ;
+    tab->searchEngine->setPattern(findDialog->getFindText(), findDialog->isCaseSensitive(),
+                                  findDialog->isRegex(), findDialog->isWholeWord());
+}
+
+/**
+ * @brief MainWindow::findMatch
+ * 在匹配位置列表上二分查找；后台还没扫描完时，普通文本从光标处直接查找，
+ * 正则表达式等扫描完成后再查找，都不阻塞界面
+ */
+void MainWindow::findMatch(bool backward)
+{
+    updateSearchPattern();
+    DocumentTab* tab = currentTab();
+    SearchEngine* engine = tab->searchEngine;
+    QTextCursor tc = tab->editor->textCursor();
+
+    queuedFind = NoQueuedFind;
+    if (!engine->isPatternValid())
+        return ;
+    if (!engine->isReady())
+    {
+        if (engine->isRegex())
+        {
+            queuedFind = backward ? QueuedFindPrev : QueuedFindNext;
+            return ;
+        }
+        int pos = backward ? engine->findPrev(tc.selectionStart()) : engine->findNext(tc.selectionEnd());
+        if (pos < 0 && findDialog->isLoop()) // 没找到，从另一端开始
+            pos = backward ? engine->findPrev(tab->textBuffer->length()) : engine->findNext(0);
+        if (pos < 0)
+            return ;
+        tc.setPosition(pos);
+        tc.setPosition(pos + findDialog->getFindText().length(), QTextCursor::KeepAnchor);
+        tab->editor->setTextCursor(tc); // 第几个等扫描完成后由 updateMatchInfo 显示
+        return ;
+    }
+
+    int index = backward ? engine->prevMatch(tc.selectionStart())
+                         : engine->nextMatch(tc.selectionEnd());
+    if (index < 0 && findDialog->isLoop() && engine->count() > 0)
+        index = backward ? engine->count() - 1 : 0;
+    if (index < 0)
+    {
+        findDialog->setMatchInfo(0, engine->count());
+        return ;
+    }
+
+    const int pos = engine->matchAt(index);
+    tc.setPosition(pos);
+    tc.setPosition(pos + engine->matchLength(index), QTextCursor::KeepAnchor);
+    tab->editor->setTextCursor(tc);
+    findDialog->setMatchInfo(index + 1, engine->count());
+}
+
+/**
+ * @brief MainWindow::updateMatchInfo
+ * 选中的正好是一个匹配时显示它是第几个
+ */
+void MainWindow::updateMatchInfo()
+{
+    DocumentTab* tab = currentTab();
+    SearchEngine* engine = tab->searchEngine;
+    if (!engine->isPatternValid())
+    {
+        findDialog->setMessage("正则表达式错误：" + engine->errorString());
+        return ;
+    }
+    if (!engine->isReady() || findDialog->getFindText().isEmpty())
+    {
+        findDialog->setMatchInfo(0, -1);
+        return ;
+    }
+
+    QTextCursor tc = tab->editor->textCursor();
+    int index = engine->matchIndex(tc.selectionStart(), tc.selectionEnd());
+    findDialog->setMatchInfo(index + 1, engine->count());
+}
+
+/**
+ * @brief MainWindow::updateSearchHighlights
+ * 只给可见区域内的匹配加背景，数量与文档大小无关
+ */
+void MainWindow::updateSearchHighlights()
+{
+    DocumentTab* tab = currentTab();
+    if (!tab)
+        return ;
+
+    QList<QTextEdit::ExtraSelection> selections;
+    SearchEngine* engine = tab->searchEngine;
+    if (findDialog && findDialog->isVisible() && engine->isReady() && engine->count() && !tab->largeFileMode)
     {
-        qInfo() << "从末尾查找";
-        QTextCursor tc = ui->plainTextEdit->textCursor();
-        tc.setPosition(ui->plainTextEdit->toPlainText().length());
-        ui->plainTextEdit->setTextCursor(tc);
-        on_actionFind_Prev_V_triggered();
+        QPlainTextEdit* edit = tab->editor;
+        QTextCursor first = edit->cursorForPosition(QPoint(0, 0));
+        QTextCursor last = edit->cursorForPosition(QPoint(edit->viewport()->width(), edit->viewport()->height()));
+        const int from = first.block().position();
+        const int to = last.block().position() + last.block().length();
+
+        QTextCharFormat format;
+        format.setBackground(QColor(255, 220, 0, 160));
+        // 从前一个匹配开始，它可能延伸到可见范围内
+        int i = qMax(0, engine->prevMatch(from));
+        for (int n = 0; i < engine->count() && engine->matchAt(i) < to && n < MAX_SEARCH_HIGHLIGHTS; i++, n++)
+        {
+            const int pos = engine->matchAt(i);
+            QTextEdit::ExtraSelection selection;
+            selection.cursor = QTextCursor(edit->document());
+            selection.cursor.setPosition(pos);
+            selection.cursor.setPosition(pos + engine->matchLength(i), QTextCursor::KeepAnchor);
+            selection.format = format;
+            selections.append(selection);
+        }
     }
+    tab->editor->setExtraSelections(selections);
 }
 
+
 void MainWindow::on_actionReplace_R_triggered()
 {
     if (!findDialog)
@@ -511,10 +1686,54 @@ void MainWindow::on_actionReplace_R_triggered()
     findDialog->openFind(true);
 }
 
+/**
+ * @brief MainWindow::on_actionGoto_G_triggered
+ * 段落号和显示行号都由 QTextDocument 的块索引维护，按行号定位块是 O(log n)，不需要逐块遍历
+ */
 void MainWindow::on_actionGoto_G_triggered()
 {
-    // TODO:转到
-    // 我的记事本这个选项一直是灰色的
+    DocumentTab* tab = currentTab();
+    GotoDialog dialog(this);
+    dialog.setVisualLine(settings.value("goto/visualLine", true).toBool());
+    if (tab->largeFileMode)
+    {
+        LargeFileView* view = tab->largeFileView;
+        dialog.setLineCounts(view->lineCount(), view->lineCount());
+        dialog.setVisualLineEnabled(false);
+        dialog.setCurrentLine(view->currentLine() + 1);
+        if (dialog.exec() == QDialog::Accepted)
+            view->gotoLine(dialog.line() - 1);
+        return ;
+    }
+
+    QPlainTextEdit* edit = tab->editor;
+    QTextDocument* doc = edit->document();
+    QTextCursor tc = edit->textCursor();
+    bool wrap = edit->wordWrapMode() != QTextOption::NoWrap;
+    dialog.setLineCounts(doc->blockCount(), doc->lineCount());
+    dialog.setVisualLineEnabled(wrap);
+    dialog.setCurrentLine((dialog.isVisualLine() ? visualLineNumber(tab, tc) : tc.blockNumber()) + 1);
+    if (dialog.exec() != QDialog::Accepted)
+        return ;
+    if (wrap)
+        settings.setValue("goto/visualLine", dialog.isVisualLine());
+
+    const int line = static_cast<int>(dialog.line() - 1);
+    int pos;
+    if (dialog.isVisualLine())
+    {
+        QTextBlock block = doc->findBlockByLineNumber(line);
+        doc->documentLayout()->blockBoundingRect(block); // 确保这一段已经排版
+        QTextLine textLine = block.layout()->lineAt(line - block.firstLineNumber());
+        pos = block.position() + (textLine.isValid() ? textLine.textStart() : 0);
+    }
+    else
+    {
+        pos = doc->findBlockByNumber(line).position();
+    }
+    tc.setPosition(pos);
+    edit->setTextCursor(tc);
+    edit->centerCursor();
 }
 
 void MainWindow::on_actionHelp_triggered()
@@ -527,82 +1746,103 @@ void MainWindow::on_actionFeedback_F_triggered()
     QDesktopServices::openUrl(QUrl("https://github.com/iwxyi/Qt-notepad/issues"));
 }
 
-void MainWindow::on_plainTextEdit_customContextMenuRequested(const QPoint&)
-{
-    QMenu* menu = new QMenu();
-
-    QMenu* insertUnicodeControlCharsMenu = new QMenu("插入 Unicode 控制字符(&I)", menu);
-    QList<QPair<QString, QString>> unicodeControlChars{
-        {"LRM", "&Left-to-right mark"},
-        {"RLM", "&Right-to-left mark"},
-        {"ZWJ", "Zero width joiner"},
-        {"ZWNJ", "Zero width &non-joiner"},
-        {"LRE", "Start of left-to-right &embedding"},
-        {"RLE", "Start of right-to-left e&mbedding"},
-        {"LRO", "Start of left-to-right &override"},
-        {"RLO", "Start of right-to-left o&verride"},
-        {"PDF", "&Pop directional formatting"},
-        {"NADS", "N&ational digit shapes substitution"},
-        {"NODS", "Nominal (European) &digit shapes"},
-        {"ASS", "Activate &symmetric swapping"},
-        {"ISS", "Inhibit s&ymmetric swapping"},
-        {"AAFS", "Activate Arabic &form shaping"},
-        {"IAFS", "Inhibit Arabic form s&haping"},
-        {"RS", "Record Separator (&Block separator)"},
-        {"US", "Unit Separator (&Segment separator)"}
+/**
+ * @brief MainWindow::createContextMenu
+ * 右键菜单只创建一次，菜单项都是共用的 QAction，启用状态随编辑器变化
+ */
+void MainWindow::createContextMenu()
+{
+    contextMenu = new QMenu(this);
+
+    insertControlCharMenu = new QMenu("插入 Unicode 控制字符(&I)", contextMenu);
+    insertControlCharMenu->setToolTipsVisible(true);
+    struct ControlChar
+    {
+        const char* name;
+        const char* tip;
+        ushort code;
+    };
+    static const ControlChar controlChars[] = {
+        {"LRM", "&Left-to-right mark", 0x200E},
+        {"RLM", "&Right-to-left mark", 0x200F},
+        {"ZWJ", "Zero width joiner", 0x200D},
+        {"ZWNJ", "Zero width &non-joiner", 0x200C},
+        {"LRE", "Start of left-to-right &embedding", 0x202A},
+        {"RLE", "Start of right-to-left e&mbedding", 0x202B},
+        {"LRO", "Start of left-to-right &override", 0x202D},
+        {"RLO", "Start of right-to-left o&verride", 0x202E},
+        {"PDF", "&Pop directional formatting", 0x202C},
+        {"NADS", "N&ational digit shapes substitution", 0x206E},
+        {"NODS", "Nominal (European) &digit shapes", 0x206F},
+        {"ASS", "Activate &symmetric swapping", 0x206B},
+        {"ISS", "Inhibit s&ymmetric swapping", 0x206A},
+        {"AAFS", "Activate Arabic &form shaping", 0x206D},
+        {"IAFS", "Inhibit Arabic form s&haping", 0x206C},
+        {"RS", "Record Separator (&Block separator)", 0x001E},
+        {"US", "Unit Separator (&Segment separator)", 0x001F}
     };
-    for (auto p: unicodeControlChars)
-    {
-        QAction* action = new QAction(p.first, insertUnicodeControlCharsMenu);
-        action->setToolTip(p.second);
-        // TODO: 把提示也显示出来
-        connect(action, &QAction::triggered, ui->plainTextEdit, [=]{
-            // TODO: 插入 Unicode 控制字符
-            // ui->plainTextEdit->insertPlainText("\u202c");
-        });
-        insertUnicodeControlCharsMenu->addAction(action);
-    }
-
-    menu->addAction(ui->actionUndo_U);
-    menu->addSeparator();
-    menu->addAction(ui->actionCut_T);
-    menu->addAction(ui->actionCopy_C);
-    menu->addAction(ui->actionPaste_P);
-    menu->addAction(ui->actionDelete_L);
-    menu->addSeparator();
-    menu->addAction(ui->actionSelect_All_A);
-    menu->addSeparator();
-    menu->addAction(ui->actionRead_Direction);
-    menu->addAction(ui->actionShow_Unicode_Control_Chars);
-    menu->addMenu(insertUnicodeControlCharsMenu);
-    menu->addSeparator();
-    menu->addAction(ui->actionRead_Mode);
-    menu->addAction(ui->actionReselect_Chinese);
-    menu->addSeparator();
-    menu->addAction(ui->actionSearch_By_Bing);
-
-    menu->exec(QCursor::pos());
-    menu->deleteLater();
+    for (const ControlChar& c: controlChars)
+    {
+        QAction* action = insertControlCharMenu->addAction(c.name);
+        action->setToolTip(c.tip);
+        action->setData(QChar(c.code));
+    }
+    // 所有控制字符共用一个连接，插入到当前标签页的光标处
+    connect(insertControlCharMenu, &QMenu::triggered, this, [=](QAction* action){
+        currentTab()->editor->insertPlainText(QString(action->data().toChar()));
+    });
+
+    contextMenu->addAction(ui->actionUndo_U);
+    contextMenu->addSeparator();
+    contextMenu->addAction(ui->actionCut_T);
+    contextMenu->addAction(ui->actionCopy_C);
+    contextMenu->addAction(ui->actionPaste_P);
+    contextMenu->addAction(ui->actionDelete_L);
+    contextMenu->addSeparator();
+    contextMenu->addAction(ui->actionSelect_All_A);
+    contextMenu->addSeparator();
+    contextMenu->addAction(ui->actionRead_Direction);
+    contextMenu->addAction(ui->actionShow_Unicode_Control_Chars);
+    contextMenu->addMenu(insertControlCharMenu);
+    contextMenu->addSeparator();
+    contextMenu->addAction(ui->actionRead_Mode);
+    contextMenu->addAction(ui->actionReselect_Chinese);
+    contextMenu->addSeparator();
+    contextMenu->addAction(ui->actionSearch_By_Bing);
+}
+
+void MainWindow::onEditorContextMenuRequested(const QPoint&)
+{
+    if (!contextMenu)
+    {
+        createContextMenu();
+    }
+
+    // 其余菜单项的状态已经随编辑器信号更新，这里只刷新插入控制字符
+    insertControlCharMenu->setEnabled(!currentTab()->editor->isReadOnly());
+    contextMenu->exec(QCursor::pos());
 }
 
 void MainWindow::on_actionRead_Direction_triggered()
 {
     auto direction = ui->actionRead_Direction->isChecked() ? Qt::RightToLeft : Qt::LeftToRight;
-    ui->plainTextEdit->setLayoutDirection(direction);
+    currentTab()->editor->setLayoutDirection(direction);
 }
 
 void MainWindow::on_actionRead_Mode_triggered()
 {
-    if (ui->plainTextEdit->isReadOnly())
+    QPlainTextEdit* edit = currentTab()->editor;
+    if (edit->isReadOnly())
     {
-        ui->plainTextEdit->setReadOnly(false);
+        edit->setReadOnly(false);
         ui->actionRead_Mode->setText("关闭输入法(&L)");
     }
     else
     {
-        ui->plainTextEdit->setReadOnly(true);
+        edit->setReadOnly(true);
         ui->actionRead_Mode->setText("打开输入法(&O)");
     }
+    updateDeleteAction();
 }
 
 void MainWindow::on_actionShow_Unicode_Control_Chars_triggered()
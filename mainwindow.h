@@ -2,9 +2,16 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
-#include <QSettings>
 #include <QLabel>
+#include <QMenu>
+#include <QProgressBar>
+#include <QPushButton>
+#include <QTimer>
+#include <QTextCursor>
+#include <QHash>
 #include "finddialog.h"
+#include "settingscache.h"
+#include "documenttab.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
@@ -19,13 +26,19 @@ public:
     ~MainWindow() override;
 
 private slots:
-    void on_plainTextEdit_textChanged();
+    void onEditorTextChanged();
 
-    void on_plainTextEdit_undoAvailable(bool b);
+    void onEditorUndoAvailable(bool b);
 
-    void on_plainTextEdit_selectionChanged();
+    void onEditorSelectionChanged();
 
-    void on_plainTextEdit_cursorPositionChanged();
+    void onEditorCursorPositionChanged();
+
+    void onEditorContextMenuRequested(const QPoint &);
+
+    void onCurrentTabChanged(int index);
+
+    void onTabCloseRequested(int index);
 
     void on_actionNew_triggered();
 
@@ -37,6 +50,8 @@ private slots:
 
     bool on_actionSave_As_triggered();
 
+    void on_actionClose_Tab_triggered();
+
     void on_actionExit_triggered();
 
     void on_actionUndo_U_triggered();
@@ -66,6 +81,7 @@ private slots:
     void on_actionZoom_Default_triggered();
 
     void on_actionStatus_Bar_S_triggered();
+    void on_actionFollow_Tail_triggered();
 
     void on_actionAbout_A_triggered();
 
@@ -83,8 +99,6 @@ private slots:
 
     void on_actionFeedback_F_triggered();
 
-    void on_plainTextEdit_customContextMenuRequested(const QPoint &);
-
     void on_actionRead_Direction_triggered();
 
     void on_actionRead_Mode_triggered();
@@ -99,32 +113,99 @@ private slots:
 
 public:
     void openFile(QString path);
+    void openFromInstance(const QStringList& paths);
+    static MainWindow* activeInstance();
     bool isModified() const;
+    void checkRecovery();
 
 private:
-    bool askSave();
-    void updateWindowTitle();
+    void initDeferred();
+    void createStatusBar();
+    bool recoverJournal(const QString& journalPath);
+    DocumentTab* currentTab() const;
+    DocumentTab* tabAt(int index) const;
+    DocumentTab* createTab();
+    DocumentTab* blankTab();
+    bool closeTab(DocumentTab* tab);
+    bool askSave(DocumentTab* tab);
+    void waitForSave(DocumentTab* tab);
+    bool save(DocumentTab* tab);
+    void startSave(DocumentTab* tab);
+    void finishSave(DocumentTab* tab, bool ok, const QString& path, const QString& error);
+    void updateWindowTitle(DocumentTab* tab);
+    void syncCurrentTab();
     void createFindDialog();
+    void createContextMenu();
+    void updateSearchPattern();
+    void findMatch(bool backward);
+    void replaceNext();
+    void runQueuedFind();
+    int replaceAll(DocumentTab* tab, const QString& replaceText);
+    void updateMatchInfo();
+    void updateSearchHighlights();
+    void loadFile(DocumentTab* tab, const QString& path);
+    void appendLoadedChunks(DocumentTab* tab);
+    void finishLoading(DocumentTab* tab, bool cancelled);
+    void appendFileTail(DocumentTab* tab);
+    void askReload(DocumentTab* tab);
+    void updateLoadProgress();
+    void updateDeleteAction();
+    void setLargeFileMode(DocumentTab* tab, bool enable);
+    void setCodec(DocumentTab* tab, const QByteArray& name, bool bom);
+    void setLineEnding(DocumentTab* tab, LineEnding::Style style, bool mixed);
+    void setEditorText(DocumentTab* tab, const QString& text);
+    void scheduleLayout(DocumentTab* tab);
+    int visualLineNumber(DocumentTab* tab, const QTextCursor& tc);
+    void scheduleStatusBar();
+    void updateStatusBar();
+    void setZoom(int percent);
+    void applyZoom(DocumentTab* tab);
 
 protected:
     void showEvent(QShowEvent* e) override;
+    void changeEvent(QEvent* e) override;
     void closeEvent(QCloseEvent* e) override;
+    bool eventFilter(QObject* obj, QEvent* e) override;
 
 private:
     Ui::MainWindow *ui;
-    QSettings settings;
-
-    QString filePath;
-    QString fileName;
-    QString savedContent;
-    int zoomSize = 100;
-
-    QLabel* posLabel;
-    QLabel* zoomLabel;
-    QLabel* lineLabel;
-    QLabel* codecLabel;
+    SettingsCache& settings;
+
+    DocumentTab* previousTab = nullptr; // 切换前的标签页，用于释放排版
+    bool firstPainted = false;
+    bool recoveryPending = false;       // 首次绘制之后再检查恢复日志
+    QFont baseFont;               // 设置中的字体，即 100%
+    QHash<int, QFont> zoomFonts;  // 各缩放比例的字体，所有标签页共用
+    QTimer zoomTimer;
+    int wheelZoomDelta = 0;
+    int pinchStartZoom = 100;
+
+    QLabel* posLabel = nullptr;   // 状态栏在首次绘制之后才创建
+    QLabel* charLabel = nullptr;
+    QLabel* zoomLabel = nullptr;
+    QLabel* lineLabel = nullptr;
+    QLabel* codecLabel = nullptr;
+    QProgressBar* loadProgress = nullptr;
+    QPushButton* loadCancelButton = nullptr;
 
     FindDialog* findDialog = nullptr;
-    // QString findText;
+    QMenu* contextMenu = nullptr;           // 编辑区右键菜单，第一次用到时创建
+    QMenu* insertControlCharMenu = nullptr;
+    QTimer searchPatternTimer; // 输入关键词时稍后再扫描
+    QTimer highlightTimer;     // 合并滚动、编辑引起的高亮刷新
+    enum QueuedFind
+    {
+        NoQueuedFind,
+        QueuedFindNext,
+        QueuedFindPrev,
+        QueuedReplaceNext
+    };
+    QueuedFind queuedFind = NoQueuedFind; // 正则表达式还在后台扫描，完成后再执行
+
+    QTimer statusTimer;        // 状态栏每帧最多刷新一次
+    int shownLine = 0;         // 状态栏上正在显示的值
+    int shownColumn = 0;
+    int shownSelection = -1;
+    int shownChars = -1;
 };
 #endif // MAINWINDOW_H
@@ -0,0 +1,169 @@
+#include <algorithm>
+#include "piecetable.h"
+
+// 追加缓冲区的容量；快照之后再追加只会复制当前这一个缓冲区
+static const int ADD_BUFFER_SIZE = 64 * 1024;
+
+PieceTable::PieceTable(const QString &text)
+{
+    append(text);
+}
+
+int PieceTable::length() const
+{
+    return total;
+}
+
+bool PieceTable::isEmpty() const
+{
+    return total == 0;
+}
+
+QChar PieceTable::at(int position) const
+{
+    const int i = findPiece(position);
+    const Piece& p = pieces.at(i);
+    return buffers.at(p.buffer).at(p.start + position - offsets.at(i));
+}
+
+QString PieceTable::mid(int position, int n) const
+{
+    position = qBound(0, position, total);
+    n = qBound(0, n, total - position);
+    QString result;
+    if (!n)
+        return result;
+    result.reserve(n);
+    for (int i = findPiece(position); n > 0; i++)
+    {
+        const Piece& p = pieces.at(i);
+        const int skip = position - offsets.at(i);
+        const int take = qMin(n, p.length - skip);
+        result.append(buffers.at(p.buffer).constData() + p.start + skip, take);
+        position += take;
+        n -= take;
+    }
+    return result;
+}
+
+QString PieceTable::toString() const
+{
+    if (pieces.size() == 1 && pieces.first().start == 0
+            && pieces.first().length == buffers.at(pieces.first().buffer).length())
+        return buffers.at(pieces.first().buffer); // 没有编辑过，直接共享原文
+    return mid(0, total);
+}
+
+/**
+ * @brief PieceTable::insert
+ * 紧接在上一次插入之后的输入合并到同一个片段
+ */
+void PieceTable::insert(int position, const QString &text)
+{
+    if (text.isEmpty())
+        return ;
+    position = qBound(0, position, total);
+    const Piece piece = store(text);
+    const int index = splitAt(position);
+
+    if (index > 0)
+    {
+        Piece& prev = pieces[index - 1];
+        if (prev.buffer == piece.buffer && prev.start + prev.length == piece.start)
+        {
+            prev.length += piece.length;
+            shiftOffsets(index, piece.length);
+            total += piece.length;
+            return ;
+        }
+    }
+    pieces.insert(index, piece);
+    offsets.insert(index, position);
+    shiftOffsets(index + 1, piece.length);
+    total += piece.length;
+}
+
+void PieceTable::append(const QString &text)
+{
+    insert(total, text);
+}
+
+void PieceTable::remove(int position, int n)
+{
+    position = qBound(0, position, total);
+    n = qBound(0, n, total - position);
+    if (!n)
+        return ;
+    const int first = splitAt(position);
+    const int last = splitAt(position + n);
+    pieces.remove(first, last - first);
+    offsets.remove(first, last - first);
+    shiftOffsets(first, -n);
+    total -= n;
+}
+
+void PieceTable::clear()
+{
+    *this = PieceTable();
+}
+
+/**
+ * @brief PieceTable::findPiece
+ * @return 包含 position 的片段下标
+ */
+int PieceTable::findPiece(int position) const
+{
+    auto it = std::upper_bound(offsets.constBegin(), offsets.constEnd(), position);
+    return static_cast<int>(it - offsets.constBegin()) - 1;
+}
+
+/**
+ * @brief PieceTable::splitAt
+ * 必要时把片段从 position 处一分为二
+ * @return 从 position 开始的片段下标，position 在末尾时为片段数
+ */
+int PieceTable::splitAt(int position)
+{
+    if (position >= total)
+        return pieces.size();
+    const int i = findPiece(position);
+    const int offset = position - offsets.at(i);
+    if (offset == 0)
+        return i;
+
+    Piece& p = pieces[i];
+    const Piece tail{p.buffer, p.start + offset, p.length - offset};
+    p.length = offset;
+    pieces.insert(i + 1, tail);
+    offsets.insert(i + 1, position);
+    return i + 1;
+}
+
+/**
+ * @brief PieceTable::store
+ * 大段文字（读入的原文、粘贴）单独占一个缓冲区，不复制；小段追加到当前追加缓冲区
+ */
+PieceTable::Piece PieceTable::store(const QString &text)
+{
+    if (text.length() >= ADD_BUFFER_SIZE)
+    {
+        buffers.append(text);
+        return Piece{buffers.size() - 1, 0, text.length()};
+    }
+    if (addBuffer < 0 || buffers.at(addBuffer).length() + text.length() > ADD_BUFFER_SIZE)
+    {
+        buffers.append(QString());
+        addBuffer = buffers.size() - 1;
+        buffers[addBuffer].reserve(ADD_BUFFER_SIZE);
+    }
+    QString& buffer = buffers[addBuffer];
+    const int start = buffer.length();
+    buffer.append(text);
+    return Piece{addBuffer, start, text.length()};
+}
+
+void PieceTable::shiftOffsets(int from, int delta)
+{
+    for (int i = from; i < offsets.size(); i++)
+        offsets[i] += delta;
+}
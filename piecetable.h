@@ -0,0 +1,52 @@
+#ifndef PIECETABLE_H
+#define PIECETABLE_H
+
+#include <QString>
+#include <QVector>
+
+/**
+ * 片段表
+ * 文本由若干片段拼成，每个片段指向某个只读缓冲区中的一段：
+ * 读入的原文各占一个缓冲区，之后插入的文字追加到固定容量的追加缓冲区中，
+ * 已写入的部分不再改动。按位置查找片段是二分查找。
+ * 所有成员都是隐式共享的，复制一份就是快照，可以交给后台线程读取
+ */
+class PieceTable
+{
+public:
+    PieceTable() = default;
+    explicit PieceTable(const QString& text);
+
+    int length() const;
+    bool isEmpty() const;
+    QChar at(int position) const;
+    QString mid(int position, int n) const;
+    QString toString() const;
+
+    void insert(int position, const QString& text);
+    void append(const QString& text);
+    void remove(int position, int n);
+    void clear();
+
+private:
+    struct Piece
+    {
+        int buffer;
+        int start;
+        int length;
+    };
+
+    int findPiece(int position) const;
+    int splitAt(int position);
+    Piece store(const QString& text);
+    void shiftOffsets(int from, int delta);
+
+private:
+    QVector<QString> buffers; // 原文和追加缓冲区，写入的部分不再改动
+    QVector<Piece> pieces;
+    QVector<int> offsets;     // 每个片段在全文中的起始位置
+    int total = 0;
+    int addBuffer = -1;       // 当前追加缓冲区的下标
+};
+
+#endif // PIECETABLE_H
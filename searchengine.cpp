@@ -0,0 +1,492 @@
+#include <QtConcurrent/QtConcurrent>
+#include <algorithm>
+#include "searchengine.h"
+#include "textbuffer.h"
+
+static const int SCAN_BLOCK_SIZE = 1024 * 1024; // 后台扫描每块检查一次是否取消
+static const int REGEX_CACHE_SIZE = 32;
+static const int FIND_WINDOW_SIZE = 64 * 1024; // 直接查找时每次从片段表取出的字符数
+static const int REGEX_OVERLAP = 64 * 1024;    // 正则表达式跨行匹配时最多越过窗口末尾这么多字符
+static const int REGEX_CONTEXT = 4 * 1024;     // 重新匹配单个位置时前后多取的字符，供环视、\b、^ 判断
+
+SearchEngine::SearchEngine(TextBuffer *buffer, QObject *parent)
+    : QObject(parent), buffer(buffer)
+{
+    rescanTimer.setSingleShot(true);
+    rescanTimer.setInterval(100);
+    connect(&rescanTimer, &QTimer::timeout, this, &SearchEngine::startScan);
+    connect(&watcher, &QFutureWatcher<ScanResult>::finished, this, &SearchEngine::onScanFinished);
+    connect(buffer, &TextBuffer::contentsChange, this, &SearchEngine::onContentsChange);
+}
+
+SearchEngine::~SearchEngine()
+{
+    cancelScan();
+    future.waitForFinished();
+}
+
+/**
+ * @brief SearchEngine::setPattern
+ * 关键词或选项变化时重新扫描全文；正则表达式按关键词和选项缓存，
+ * 重复查找同一个表达式不会重新编译
+ */
+void SearchEngine::setPattern(const QString &pattern, bool caseSensitive, bool regex, bool wholeWord)
+{
+    if (pattern == this->pattern && caseSensitive == this->caseSensitive
+            && regex == this->regex && wholeWord == this->wholeWord)
+        return ;
+    this->pattern = pattern;
+    this->caseSensitive = caseSensitive;
+    this->regex = regex;
+    this->wholeWord = wholeWord;
+    matcher = TextMatcher(pattern, caseSensitive, wholeWord);
+
+    re = QRegularExpression();
+    if (regex && !pattern.isEmpty())
+    {
+        const QString key = QString::number(caseSensitive) + QString::number(wholeWord) + pattern;
+        auto it = regexCache.constFind(key);
+        if (it != regexCache.constEnd())
+        {
+            re = it.value();
+        }
+        else
+        {
+            re = compile(pattern, caseSensitive, wholeWord);
+            if (regexCache.size() >= REGEX_CACHE_SIZE)
+                regexCache.clear();
+            regexCache.insert(key, re);
+        }
+    }
+    startScan();
+}
+
+/**
+ * @brief SearchEngine::compile
+ * 查找框与命令行批处理使用同样的选项编译正则表达式；
+ * 全字匹配时 \b 按 Unicode 判断单词字符，与普通查找的全字匹配一致，中文也算单词字符
+ */
+QRegularExpression SearchEngine::compile(const QString &pattern, bool caseSensitive, bool wholeWord)
+{
+    QRegularExpression::PatternOptions options = QRegularExpression::MultilineOption;
+    if (!caseSensitive)
+        options |= QRegularExpression::CaseInsensitiveOption;
+    if (wholeWord)
+        options |= QRegularExpression::UseUnicodePropertiesOption;
+    QRegularExpression re(wholeWord ? "\\b(?:" + pattern + ")\\b" : pattern, options);
+    re.optimize(); // 立即编译，可用时启用 JIT
+    return re;
+}
+
+void SearchEngine::clear()
+{
+    rescanTimer.stop();
+    cancelScan();
+    pattern.clear();
+    matcher = TextMatcher();
+    re = QRegularExpression();
+    matches.clear();
+    lengths.clear();
+    ready = false;
+}
+
+/**
+ * @brief SearchEngine::waitForFinished
+ * 需要完整结果时（如全部替换）等待后台扫描完成
+ */
+void SearchEngine::waitForFinished()
+{
+    if (ready || pattern.isEmpty())
+        return ;
+    if (rescanTimer.isActive() || !cancelled)
+        startScan();
+    future.waitForFinished();
+    onScanFinished();
+}
+
+bool SearchEngine::isReady() const
+{
+    return ready;
+}
+
+bool SearchEngine::isRegex() const
+{
+    return regex;
+}
+
+bool SearchEngine::isPatternValid() const
+{
+    return !regex || re.isValid();
+}
+
+QString SearchEngine::errorString() const
+{
+    return isPatternValid() ? QString() : re.errorString();
+}
+
+int SearchEngine::count() const
+{
+    return matches.size();
+}
+
+int SearchEngine::matchAt(int index) const
+{
+    return matches.at(index);
+}
+
+int SearchEngine::matchLength(int index) const
+{
+    return lengths.isEmpty() ? pattern.length() : lengths.at(index);
+}
+
+/**
+ * @brief SearchEngine::nextMatch
+ * @return 第一个位置 >= position 的匹配序号，没有则 -1
+ */
+int SearchEngine::nextMatch(int position) const
+{
+    auto it = std::lower_bound(matches.constBegin(), matches.constEnd(), position);
+    return it == matches.constEnd() ? -1 : static_cast<int>(it - matches.constBegin());
+}
+
+/**
+ * @brief SearchEngine::prevMatch
+ * @return 最后一个位置 < position 的匹配序号，没有则 -1
+ */
+int SearchEngine::prevMatch(int position) const
+{
+    auto it = std::lower_bound(matches.constBegin(), matches.constEnd(), position);
+    return static_cast<int>(it - matches.constBegin()) - 1;
+}
+
+/**
+ * @brief SearchEngine::matchIndex
+ * @return [start, end) 正好是一个匹配时返回它的序号，否则 -1
+ */
+int SearchEngine::matchIndex(int start, int end) const
+{
+    int index = nextMatch(start);
+    if (index < 0 || matches.at(index) != start || start + matchLength(index) != end)
+        return -1;
+    return index;
+}
+
+/**
+ * @brief SearchEngine::findNext
+ * 后台扫描还没完成时，从 position 起分段直接查找普通文本，找到第一个就停
+ * @return 匹配位置，没有则 -1
+ */
+int SearchEngine::findNext(int position) const
+{
+    const PieceTable text = buffer->text();
+    const int n = text.length();
+    const int m = matcher.length();
+    const int margin = wholeWord ? 1 : 0;
+    for (int start = qMax(0, position); m > 0 && start <= n - m; start += FIND_WINDOW_SIZE)
+    {
+        const int from = qMax(0, start - margin);
+        const int to = qMin(n, start + FIND_WINDOW_SIZE + m - 1 + margin);
+        const QString window = text.mid(from, to - from);
+        const int i = matcher.indexIn(window.constData(), window.length(), start - from);
+        if (i >= 0 && from + i < start + FIND_WINDOW_SIZE)
+            return from + i;
+    }
+    return -1;
+}
+
+/**
+ * @brief SearchEngine::findPrev
+ * 同 findNext，从 position 往前分段查找
+ * @return 最后一个位置 < position 的匹配，没有则 -1
+ */
+int SearchEngine::findPrev(int position) const
+{
+    const PieceTable text = buffer->text();
+    const int n = text.length();
+    const int m = matcher.length();
+    const int margin = wholeWord ? 1 : 0;
+    for (int end = qMin(position, n); m > 0 && end > 0; end -= FIND_WINDOW_SIZE)
+    {
+        const int start = qMax(0, end - FIND_WINDOW_SIZE);
+        const int from = qMax(0, start - margin);
+        const int to = qMin(n, end + m - 1 + margin);
+        const QString window = text.mid(from, to - from);
+        int found = -1;
+        for (int i = matcher.indexIn(window.constData(), window.length(), start - from);
+             i >= 0 && from + i < end; i = matcher.indexIn(window.constData(), window.length(), i + 1))
+            found = from + i;
+        if (found >= 0)
+            return found;
+    }
+    return -1;
+}
+
+/**
+ * @brief SearchEngine::isMatch
+ * 不依赖扫描结果判断 [start, end) 是否正好是一个普通文本匹配
+ */
+bool SearchEngine::isMatch(int start, int end) const
+{
+    const int m = matcher.length();
+    if (m == 0 || end - start != m)
+        return false;
+    const int margin = wholeWord ? 1 : 0;
+    const int from = qMax(0, start - margin);
+    const QString window = buffer->text().mid(from, end + margin - from);
+    return matcher.matchesAt(window.constData(), window.length(), start - from);
+}
+
+/**
+ * @brief SearchEngine::replacementFor
+ * 替换 [start, end) 这个匹配时实际写入的文本：普通查找原样返回，
+ * 正则表达式在 start 处带着前后文重新匹配一次，展开其中的捕获组
+ */
+QString SearchEngine::replacementFor(int start, int end, const QString &replacement) const
+{
+    if (!regex || !re.isValid())
+        return replacement;
+    const PieceTable text = buffer->text();
+    const int from = qMax(0, start - REGEX_CONTEXT);
+    const QString window = text.mid(from, qMin(text.length(), end + REGEX_CONTEXT) - from);
+    const QRegularExpressionMatch match = re.match(window, start - from, QRegularExpression::NormalMatch,
+                                                   QRegularExpression::AnchoredMatchOption);
+    if (!match.hasMatch() || match.capturedLength() != end - start)
+        return replacement;
+    return expandReplacement(replacement, match);
+}
+
+/**
+ * @brief SearchEngine::expandReplacement
+ * 替换文本中的 \1、$1 换成对应的捕获组，\0、$0 是整个匹配，组号最多两位；
+ * \\、$$ 表示字符本身，其余字符原样保留
+ */
+QString SearchEngine::expandReplacement(const QString &replacement, const QRegularExpressionMatch &match)
+{
+    const int groups = match.regularExpression().captureCount();
+    QString result;
+    result.reserve(replacement.length());
+    for (int i = 0; i < replacement.length(); i++)
+    {
+        const QChar c = replacement.at(i);
+        const QChar next = i + 1 < replacement.length() ? replacement.at(i + 1) : QChar();
+        if ((c == '\\' || c == '$') && next == c)
+        {
+            result += c;
+            i++;
+        }
+        else if ((c == '\\' || c == '$') && next >= '0' && next <= '9')
+        {
+            int group = next.digitValue();
+            i++;
+            const QChar second = i + 1 < replacement.length() ? replacement.at(i + 1) : QChar();
+            if (second >= '0' && second <= '9' && group * 10 + second.digitValue() <= groups)
+            {
+                group = group * 10 + second.digitValue();
+                i++;
+            }
+            result += match.captured(group);
+        }
+        else
+        {
+            result += c;
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief SearchEngine::regularExpression
+ * 当前使用的正则表达式（普通查找时无效）
+ */
+QRegularExpression SearchEngine::regularExpression() const
+{
+    return re;
+}
+
+/**
+ * @brief SearchEngine::onContentsChange
+ * 只有起点落在 [position - m + 1, position + removed) 的匹配会受影响，
+ * 删掉它们，后面的平移，再扫描改动附近的文本
+ */
+void SearchEngine::onContentsChange(int position, int charsRemoved, int charsAdded)
+{
+    if (pattern.isEmpty() || (!charsRemoved && !charsAdded))
+        return ;
+    if (!ready || regex) // 正在后台扫描，或正则表达式无法局部更新
+    {
+        cancelScan();
+        ready = false;
+        rescanTimer.start();
+        emit matchesChanged();
+        return ;
+    }
+
+    // 全字匹配时前后各多一个字符会影响结果
+    const int m = pattern.length();
+    const int margin = wholeWord ? 1 : 0;
+    const int delta = charsAdded - charsRemoved;
+    auto first = std::lower_bound(matches.begin(), matches.end(), position - m + 1 - margin);
+    auto last = std::lower_bound(first, matches.end(), position + charsRemoved + margin);
+    const int firstIndex = static_cast<int>(first - matches.begin());
+    matches.erase(first, last);
+    for (int i = firstIndex; i < matches.size(); i++)
+        matches[i] += delta;
+
+    // 重新扫描起点在 [lo, hi) 的匹配，取的文本两边再各多 margin 个字符用于判断边界
+    const int length = buffer->length();
+    const int lo = qMax(0, position - m + 1 - margin);
+    const int hi = position + charsAdded + margin;
+    const int from = qMax(0, lo - margin);
+    const int to = qMin(length, hi + m - 1 + margin);
+    if (to <= from)
+    {
+        emit matchesChanged();
+        return ;
+    }
+    const QString text = buffer->text().mid(from, to - from);
+
+    QVector<int> found;
+    for (int i = matcher.indexIn(text.constData(), text.length(), lo - from);
+         i >= 0 && from + i < hi; i = matcher.indexIn(text.constData(), text.length(), i + 1))
+        found.append(from + i);
+    if (!found.isEmpty())
+        matches = matches.mid(0, firstIndex) + found + matches.mid(firstIndex);
+    emit matchesChanged();
+}
+
+void SearchEngine::onScanFinished()
+{
+    if (!cancelled || cancelled->load())
+        return ;
+    cancelled.reset(); // 结果只取一次，waitForFinished 之后 watcher 的通知直接忽略
+    const ScanResult result = future.result();
+    matches = result.positions;
+    lengths = result.lengths;
+    ready = true;
+    emit matchesChanged();
+}
+
+/**
+ * @brief SearchEngine::startScan
+ * 取一份全文快照交给后台线程
+ */
+void SearchEngine::startScan()
+{
+    rescanTimer.stop();
+    cancelScan();
+    matches.clear();
+    lengths.clear();
+    ready = false;
+    if (pattern.isEmpty() || !isPatternValid())
+    {
+        ready = !pattern.isEmpty();
+        emit matchesChanged();
+        return ;
+    }
+
+    cancelled = QSharedPointer<QAtomicInt>::create(0);
+    const PieceTable snapshot = buffer->text(); // 只复制片段列表，拼接在后台线程进行
+    const TextMatcher m = matcher;
+    const QRegularExpression r = re;
+    const bool useRegex = regex;
+    const QSharedPointer<QAtomicInt> flag = cancelled;
+    future = QtConcurrent::run([=]{
+        return useRegex ? scanRegex(snapshot, r, flag.data()) : scan(snapshot.toString(), m, flag.data());
+    });
+    watcher.setFuture(future);
+}
+
+/**
+ * @brief SearchEngine::cancelScan
+ * 通知后台扫描尽快结束，结果直接丢弃，不等待
+ */
+void SearchEngine::cancelScan()
+{
+    if (cancelled)
+        cancelled->store(1);
+    cancelled.reset();
+}
+
+SearchEngine::ScanResult SearchEngine::scan(const QString &text, const TextMatcher &matcher, const QAtomicInt *cancelled)
+{
+    ScanResult result;
+    const int m = matcher.length();
+    const int n = text.length();
+    int pos = 0;
+    while (pos <= n - m)
+    {
+        if (cancelled->load())
+            return ScanResult();
+
+        const int blockEnd = qMin(n, pos + SCAN_BLOCK_SIZE + m - 1);
+        int i = matcher.indexIn(text.constData(), blockEnd, pos);
+        if (i < 0)
+        {
+            pos = blockEnd - m + 1;
+            continue;
+        }
+        if (matcher.matchesAt(text.constData(), n, i)) // 块尾之后的字符也要参与单词边界判断
+            result.positions.append(i);
+        pos = i + 1;
+    }
+    return result;
+}
+
+/**
+ * @brief SearchEngine::scanRegex
+ * 按行对齐的窗口逐段取出文本匹配，每个窗口之间检查是否取消，不拼接全文。
+ * 窗口从行首开始，^、\b 与全文匹配时一致；只记录起点在窗口内的匹配，
+ * 窗口之后多取 REGEX_OVERLAP 个字符，跨行的匹配不会被切断。
+ * 空匹配（如 ^、a*）没法选中，跳过
+ */
+SearchEngine::ScanResult SearchEngine::scanRegex(const PieceTable &text, const QRegularExpression &re, const QAtomicInt *cancelled)
+{
+    ScanResult result;
+    const int n = text.length();
+    int from = 0; // 窗口起点，总在行首
+    int pos = 0;  // 下一个匹配的起点不早于这里
+    while (pos < n)
+    {
+        if (cancelled->load())
+            return ScanResult();
+
+        // 窗口在 pos 之后 SCAN_BLOCK_SIZE 处所在行的行尾结束，超长的行整行算进来
+        int limit = qMin(n, pos + SCAN_BLOCK_SIZE);
+        while (limit < n)
+        {
+            const int i = text.mid(limit, FIND_WINDOW_SIZE).indexOf('\n');
+            if (i >= 0)
+            {
+                limit += i + 1;
+                break;
+            }
+            limit = qMin(n, limit + FIND_WINDOW_SIZE);
+            if (cancelled->load())
+                return ScanResult();
+        }
+        const int to = qMin(n, limit + REGEX_OVERLAP);
+        const QString window = text.mid(from, to - from);
+
+        int next = limit;
+        QRegularExpressionMatchIterator it = re.globalMatch(window, pos - from);
+        while (it.hasNext())
+        {
+            const QRegularExpressionMatch match = it.next();
+            if (from + match.capturedStart() >= limit)
+                break;
+            if (match.capturedLength() == 0)
+                continue;
+            result.positions.append(from + match.capturedStart());
+            result.lengths.append(match.capturedLength());
+            next = qMax(next, from + match.capturedEnd());
+        }
+
+        // 最后一个匹配越过了窗口末尾：下一个窗口从它结束处所在的行首开始，匹配不重叠
+        if (next > limit)
+            from += window.lastIndexOf('\n', next - from - 1) + 1;
+        else
+            from = limit;
+        pos = next;
+    }
+    return result;
+}
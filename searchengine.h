@@ -0,0 +1,95 @@
+#ifndef SEARCHENGINE_H
+#define SEARCHENGINE_H
+
+#include <QObject>
+#include <QVector>
+#include <QHash>
+#include <QTimer>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QAtomicInt>
+#include <QSharedPointer>
+#include <QRegularExpression>
+#include "piecetable.h"
+#include "textmatcher.h"
+
+class TextBuffer;
+
+/**
+ * 查找引擎
+ * 关键词变化时在后台线程用 Boyer-Moore-Horspool 扫描全文，得到所有匹配位置（有序）；
+ * 之后文档的每次编辑只重新扫描改动附近的一小段，其余位置整体平移。
+ * 正则表达式的匹配长度不固定，编辑后稍等片刻在后台整体重新扫描。
+ * 查找下一个/上一个就是在位置列表上二分
+ */
+class SearchEngine : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SearchEngine(TextBuffer* buffer, QObject *parent = nullptr);
+    ~SearchEngine() override;
+
+    void setPattern(const QString& pattern, bool caseSensitive, bool regex = false, bool wholeWord = false);
+    void clear();
+    void waitForFinished();
+
+    bool isReady() const;
+    bool isRegex() const;
+    bool isPatternValid() const;
+    QString errorString() const;
+    int count() const;
+    int matchAt(int index) const;
+    int matchLength(int index) const;
+    int nextMatch(int position) const;
+    int prevMatch(int position) const;
+    int matchIndex(int start, int end) const;
+
+    int findNext(int position) const;
+    int findPrev(int position) const;
+    bool isMatch(int start, int end) const;
+    QString replacementFor(int start, int end, const QString& replacement) const;
+
+    QRegularExpression regularExpression() const;
+    static QRegularExpression compile(const QString& pattern, bool caseSensitive, bool wholeWord);
+    static QString expandReplacement(const QString& replacement, const QRegularExpressionMatch& match);
+
+signals:
+    void matchesChanged();
+
+private slots:
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
+    void onScanFinished();
+    void startScan();
+
+private:
+    struct ScanResult
+    {
+        QVector<int> positions;
+        QVector<int> lengths; // 只有正则表达式才有
+    };
+
+    void cancelScan();
+    static ScanResult scan(const QString& text, const TextMatcher& matcher, const QAtomicInt* cancelled);
+    static ScanResult scanRegex(const PieceTable& text, const QRegularExpression& re, const QAtomicInt* cancelled);
+
+private:
+    TextBuffer* buffer;
+    QString pattern;
+    bool caseSensitive = false;
+    bool regex = false;
+    bool wholeWord = false;
+    TextMatcher matcher;
+    bool ready = false;
+    QVector<int> matches;
+    QVector<int> lengths;
+
+    QRegularExpression re;
+    QHash<QString, QRegularExpression> regexCache; // 编译并优化过的正则表达式
+
+    QFuture<ScanResult> future;
+    QFutureWatcher<ScanResult> watcher;
+    QSharedPointer<QAtomicInt> cancelled; // 每次扫描一个，取消后不必等旧的扫描结束
+    QTimer rescanTimer; // 扫描期间文档有改动，稍后重新扫描
+};
+
+#endif // SEARCHENGINE_H
@@ -0,0 +1,320 @@
+#include <QTextDocument>
+#include <QTextCursor>
+#include <QDataStream>
+#include <QDir>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QLockFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QUuid>
+#include <QDebug>
+#include "sessionjournal.h"
+
+static const int FLUSH_INTERVAL = 2000;                  // 写入磁盘的间隔
+static const qint64 COMPACT_THRESHOLD = 8 * 1024 * 1024; // 增量超过这么多（且超过文档本身）时压缩
+static const quint8 HEADER_RECORD = 'H';
+
+static QString customDir; // 测试时指定的日志目录
+
+SessionJournal::SessionJournal(QTextDocument *doc, QObject *parent)
+    : QObject(parent), doc(doc)
+{
+    flushTimer.setSingleShot(true);
+    flushTimer.setInterval(FLUSH_INTERVAL);
+    connect(&flushTimer, &QTimer::timeout, this, &SessionJournal::flush);
+    connect(doc, &QTextDocument::contentsChange, this, &SessionJournal::onContentsChange);
+    connect(doc, &QTextDocument::modificationChanged, this, &SessionJournal::onModificationChanged);
+}
+
+SessionJournal::~SessionJournal()
+{
+    // 正常退出时由调用方决定是否 discard，留下的日志下次启动可以恢复
+    flush();
+}
+
+/**
+ * @brief SessionJournal::setHeader
+ * 路径或编码变化后，已有的日志重新压缩以写入新的文件头
+ */
+void SessionJournal::setHeader(const QString &filePath, const QByteArray &codec, bool bom, int lineStyle)
+{
+    bool changed = header.filePath != filePath || header.codec != codec
+            || header.bom != bom || header.lineStyle != lineStyle;
+    header.filePath = filePath;
+    header.codec = codec;
+    header.bom = bom;
+    header.lineStyle = lineStyle;
+    if (changed && active)
+        compact();
+}
+
+/**
+ * @brief SessionJournal::setSuspended
+ * 打开文件等整体替换内容时暂停记录
+ */
+void SessionJournal::setSuspended(bool suspended)
+{
+    this->suspended = suspended;
+}
+
+/**
+ * @brief SessionJournal::compact
+ * 用当前内容的完整快照替换日志，之前的增量全部丢弃
+ */
+void SessionJournal::compact()
+{
+    if (!active)
+        return ;
+
+    QByteArray snapshot;
+    QDataStream ds(&snapshot, QIODevice::WriteOnly);
+    ds.setVersion(QDataStream::Qt_5_0);
+    ds << quint8(Record::Snapshot) << doc->toPlainText();
+
+    file.close();
+    QSaveFile save(file.fileName());
+    if (!save.open(QIODevice::WriteOnly))
+    {
+        qWarning() << "写入恢复日志失败" << save.errorString();
+        return ;
+    }
+    save.write(headerRecord());
+    save.write(snapshot);
+    if (!save.commit())
+        qWarning() << "写入恢复日志失败" << save.errorString();
+
+    pending.clear();
+    deltaBytes = 0;
+    file.open(QIODevice::WriteOnly | QIODevice::Append);
+}
+
+/**
+ * @brief SessionJournal::discard
+ * 内容已保存或用户放弃修改，删除日志
+ */
+void SessionJournal::discard()
+{
+    flushTimer.stop();
+    pending.clear();
+    deltaBytes = 0;
+    if (!active)
+        return ;
+    active = false;
+    file.close();
+    file.remove();
+    lock.reset(); // 析构时释放并删除锁文件
+}
+
+/**
+ * @brief SessionJournal::orphanedJournals
+ * 锁已失效（所在进程已退出）的日志
+ */
+QStringList SessionJournal::orphanedJournals()
+{
+    QStringList journals;
+    QDir dir(journalDir());
+    for (const QFileInfo& info: dir.entryInfoList({"*.journal"}, QDir::Files, QDir::Time))
+    {
+        QLockFile lockFile(dir.filePath(info.completeBaseName() + ".lock"));
+        if (!lockFile.tryLock(0))
+            continue;
+        lockFile.unlock();
+        journals.append(info.absoluteFilePath());
+    }
+    return journals;
+}
+
+/**
+ * @brief SessionJournal::read
+ * 读取日志；崩溃时最后一条记录可能不完整，直接忽略
+ */
+bool SessionJournal::read(const QString &journalPath, Header *header, QVector<Record> *records)
+{
+    QFile f(journalPath);
+    if (!f.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream ds(&f);
+    ds.setVersion(QDataStream::Qt_5_0);
+    quint8 type = 0;
+    ds >> type;
+    if (type != HEADER_RECORD)
+        return false;
+    qint32 lineStyle;
+    ds >> header->filePath >> header->codec >> header->bom >> lineStyle
+       >> header->baseSize >> header->baseModified;
+    header->lineStyle = lineStyle;
+    if (ds.status() != QDataStream::Ok)
+        return false;
+
+    while (!ds.atEnd())
+    {
+        Record r;
+        ds >> r.type;
+        if (r.type == Record::Snapshot)
+        {
+            r.position = r.removed = 0;
+            ds >> r.text;
+        }
+        else if (r.type == Record::Delta)
+        {
+            ds >> r.position >> r.removed >> r.text;
+        }
+        else
+        {
+            break;
+        }
+        if (ds.status() != QDataStream::Ok)
+            break;
+        records->append(r);
+    }
+    return true;
+}
+
+/**
+ * @brief SessionJournal::isBaseUnchanged
+ * 增量是基于打开时磁盘上的文件，文件被改过就不能直接重放
+ */
+bool SessionJournal::isBaseUnchanged(const Header &header)
+{
+    if (header.filePath.isEmpty())
+        return true;
+    QFileInfo info(header.filePath);
+    return info.exists() && info.size() == header.baseSize
+            && info.lastModified().toMSecsSinceEpoch() == header.baseModified;
+}
+
+void SessionJournal::replay(const QVector<Record> &records, QTextDocument *doc)
+{
+    QTextCursor tc(doc);
+    for (const Record& r: records)
+    {
+        const int length = doc->characterCount() - 1;
+        if (r.type == Record::Snapshot)
+        {
+            tc.setPosition(0);
+            tc.setPosition(length, QTextCursor::KeepAnchor);
+        }
+        else
+        {
+            tc.setPosition(qMin(r.position, length));
+            tc.setPosition(qMin(r.position + r.removed, length), QTextCursor::KeepAnchor);
+        }
+        tc.insertText(r.text);
+    }
+}
+
+void SessionJournal::remove(const QString &journalPath)
+{
+    QFile::remove(journalPath);
+}
+
+void SessionJournal::onContentsChange(int position, int charsRemoved, int charsAdded)
+{
+    if (suspended || (!charsRemoved && !charsAdded))
+        return ;
+    // 第一次编辑时 QTextDocument 先发出 contentsChange，之后才设置 modified，
+    // 所以不能按 isModified() 过滤；撤销回未修改状态时日志在 modificationChanged 中删除
+    if (!active)
+        begin();
+
+    // 文档末尾的变化有时会多报一个字符，截断到实际长度
+    const int length = doc->characterCount() - 1;
+    QTextCursor tc(doc);
+    tc.setPosition(qMin(position, length));
+    tc.setPosition(qMin(position + charsAdded, length), QTextCursor::KeepAnchor);
+
+    QByteArray record;
+    QDataStream ds(&record, QIODevice::WriteOnly);
+    ds.setVersion(QDataStream::Qt_5_0);
+    ds << quint8(Record::Delta) << qint32(position) << qint32(charsRemoved) << tc.selectedText();
+    pending += record;
+    deltaBytes += record.size();
+    if (!flushTimer.isActive())
+        flushTimer.start();
+}
+
+void SessionJournal::onModificationChanged(bool modified)
+{
+    if (!modified)
+        discard();
+}
+
+void SessionJournal::flush()
+{
+    if (!active || pending.isEmpty())
+        return ;
+
+    if (deltaBytes > COMPACT_THRESHOLD && deltaBytes > doc->characterCount() * 2)
+    {
+        compact();
+        return ;
+    }
+    file.write(pending);
+    file.flush();
+    pending.clear();
+}
+
+/**
+ * @brief SessionJournal::begin
+ * 第一次修改时创建日志文件，写入文件头
+ */
+void SessionJournal::begin()
+{
+    QDir().mkpath(journalDir());
+    if (id.isEmpty())
+        id = QUuid::createUuid().toString().mid(1, 36);
+
+    lock.reset(new QLockFile(journalDir() + "/" + id + ".lock"));
+    lock->setStaleLockTime(0);
+    lock->tryLock(0);
+
+    if (header.filePath.isEmpty())
+    {
+        header.baseSize = header.baseModified = 0;
+    }
+    else
+    {
+        QFileInfo info(header.filePath);
+        header.baseSize = info.size();
+        header.baseModified = info.lastModified().toMSecsSinceEpoch();
+    }
+
+    file.setFileName(journalDir() + "/" + id + ".journal");
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qWarning() << "创建恢复日志失败" << file.errorString();
+        return ;
+    }
+    file.write(headerRecord());
+    file.flush();
+    active = true;
+    deltaBytes = 0;
+}
+
+QByteArray SessionJournal::headerRecord() const
+{
+    QByteArray record;
+    QDataStream ds(&record, QIODevice::WriteOnly);
+    ds.setVersion(QDataStream::Qt_5_0);
+    ds << HEADER_RECORD << header.filePath << header.codec << header.bom << qint32(header.lineStyle)
+       << header.baseSize << header.baseModified;
+    return record;
+}
+
+/**
+ * @brief SessionJournal::setDirectory
+ * 日志改写到指定目录，测试时用临时目录，不碰用户的恢复日志
+ */
+void SessionJournal::setDirectory(const QString &dir)
+{
+    customDir = dir;
+}
+
+QString SessionJournal::journalDir()
+{
+    if (!customDir.isEmpty())
+        return customDir;
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/recovery";
+}
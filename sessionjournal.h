@@ -0,0 +1,85 @@
+#ifndef SESSIONJOURNAL_H
+#define SESSIONJOURNAL_H
+
+#include <QObject>
+#include <QFile>
+#include <QTimer>
+#include <QVector>
+#include <QScopedPointer>
+
+class QTextDocument;
+class QLockFile;
+
+/**
+ * 自动保存与崩溃恢复日志
+ * 文档变为已修改时开始记录：先写文件头（路径、编码、磁盘上原文件的大小和时间），
+ * 之后每次编辑只追加 (位置, 删除数, 插入文本)，定时写入磁盘；
+ * 增量过多时压缩为一份完整快照。保存后或撤销回未修改状态时删除日志
+ */
+class SessionJournal : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SessionJournal(QTextDocument* doc, QObject *parent = nullptr);
+    ~SessionJournal() override;
+
+    struct Header
+    {
+        QString filePath;
+        QByteArray codec;
+        bool bom = false;
+        int lineStyle = 0;
+        qint64 baseSize = 0;
+        qint64 baseModified = 0;
+    };
+
+    struct Record
+    {
+        enum Type
+        {
+            Snapshot = 'S',
+            Delta = 'D'
+        };
+        quint8 type;
+        qint32 position;
+        qint32 removed;
+        QString text;
+    };
+
+    void setHeader(const QString& filePath, const QByteArray& codec, bool bom, int lineStyle);
+    void setSuspended(bool suspended);
+    void compact();
+    void discard();
+
+    static void setDirectory(const QString& dir);
+    static QStringList orphanedJournals();
+    static bool read(const QString& journalPath, Header* header, QVector<Record>* records);
+    static bool isBaseUnchanged(const Header& header);
+    static void replay(const QVector<Record>& records, QTextDocument* doc);
+    static void remove(const QString& journalPath);
+
+private slots:
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
+    void onModificationChanged(bool modified);
+    void flush();
+
+private:
+    void begin();
+    QByteArray headerRecord() const;
+    static QString journalDir();
+
+private:
+    QTextDocument* doc;
+    Header header;
+    bool suspended = false;
+    bool active = false;
+
+    QString id;
+    QFile file;
+    QScopedPointer<QLockFile> lock;
+    QByteArray pending;
+    qint64 deltaBytes = 0; // 上次快照之后写入的增量大小
+    QTimer flushTimer;
+};
+
+#endif // SESSIONJOURNAL_H
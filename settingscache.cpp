@@ -0,0 +1,69 @@
+#include <QApplication>
+#include "settingscache.h"
+
+static const int FLUSH_DELAY = 3000; // 最后一次修改之后多久写回
+
+SettingsCache::SettingsCache(QObject *parent)
+    : QObject(parent), settings("MyNotepad")
+{
+    const QStringList keys = settings.allKeys();
+    values.reserve(keys.size());
+    for (const QString& key: keys)
+        values.insert(key, settings.value(key));
+
+    flushTimer.setSingleShot(true);
+    flushTimer.setInterval(FLUSH_DELAY);
+    connect(&flushTimer, &QTimer::timeout, this, &SettingsCache::sync);
+    connect(qApp, &QCoreApplication::aboutToQuit, this, &SettingsCache::sync);
+}
+
+SettingsCache::~SettingsCache()
+{
+    sync();
+}
+
+/**
+ * @brief SettingsCache::instance
+ * 第一次用到时读取，随 QApplication 一起销毁
+ */
+SettingsCache &SettingsCache::instance()
+{
+    static SettingsCache* cache = nullptr;
+    if (!cache)
+        cache = new SettingsCache(qApp);
+    return *cache;
+}
+
+QVariant SettingsCache::value(const QString &key, const QVariant &defaultValue) const
+{
+    return values.value(key, defaultValue);
+}
+
+/**
+ * @brief SettingsCache::setValue
+ * 值没变就不标记，连续的修改合并为一次写回
+ */
+void SettingsCache::setValue(const QString &key, const QVariant &value)
+{
+    auto it = values.find(key);
+    if (it != values.end() && it.value() == value)
+        return ;
+    values.insert(key, value);
+    dirtyKeys.insert(key);
+    flushTimer.start();
+}
+
+/**
+ * @brief SettingsCache::sync
+ * 把改过的键一次写回并同步到磁盘
+ */
+void SettingsCache::sync()
+{
+    flushTimer.stop();
+    if (dirtyKeys.isEmpty())
+        return ;
+    for (const QString& key: dirtyKeys)
+        settings.setValue(key, values.value(key));
+    dirtyKeys.clear();
+    settings.sync();
+}
@@ -0,0 +1,38 @@
+#ifndef SETTINGSCACHE_H
+#define SETTINGSCACHE_H
+
+#include <QObject>
+#include <QSettings>
+#include <QHash>
+#include <QSet>
+#include <QTimer>
+#include <QVariant>
+
+/**
+ * 设置缓存
+ * 启动时一次读入全部设置，之后的读写都在内存中；
+ * 改过的键记下来，稍后或退出时一次写回 QSettings。
+ * 整个进程共用一份，多个窗口看到的设置一致
+ */
+class SettingsCache : public QObject
+{
+    Q_OBJECT
+public:
+    static SettingsCache& instance();
+    ~SettingsCache() override;
+
+    QVariant value(const QString& key, const QVariant& defaultValue = QVariant()) const;
+    void setValue(const QString& key, const QVariant& value);
+    void sync();
+
+private:
+    explicit SettingsCache(QObject *parent = nullptr);
+
+private:
+    QSettings settings;
+    QHash<QString, QVariant> values;
+    QSet<QString> dirtyKeys; // 还没写回的键
+    QTimer flushTimer;
+};
+
+#endif // SETTINGSCACHE_H
@@ -0,0 +1,102 @@
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QDataStream>
+#include <QDir>
+#include <QLockFile>
+#include <QDebug>
+#include "singleinstance.h"
+
+// 连接、发送的超时时间，运行中的实例卡住时不至于一直等
+static const int CONNECT_TIMEOUT = 500;
+// 等待另一个正在启动的进程开始监听
+static const int LOCK_TIMEOUT = 5000;
+
+SingleInstance::SingleInstance(QObject *parent) : QObject(parent)
+{
+    // 每个用户一个实例
+    serverName = "MyNotepad-" + QString::number(qHash(QDir::homePath()), 16);
+}
+
+SingleInstance::~SingleInstance()
+{
+}
+
+/**
+ * @brief SingleInstance::sendToRunning
+ * 先取得启动锁：另一个进程正在启动时等它开始监听再连接。
+ * 没有可转发的实例时锁继续持有，直到 listen() 完成
+ * @return 是否已交给正在运行的实例
+ */
+bool SingleInstance::sendToRunning(const QStringList &args)
+{
+    lock.reset(new QLockFile(QDir::temp().filePath(serverName + ".lock")));
+    lock->setStaleLockTime(0); // 持有者崩溃时按进程是否存在判断
+    if (!lock->tryLock(LOCK_TIMEOUT))
+        qWarning() << "等待启动锁超时：" << lock->error();
+
+    QLocalSocket socket;
+    socket.connectToServer(serverName);
+    if (!socket.waitForConnected(CONNECT_TIMEOUT))
+    {
+        noServer = true;
+        return false;
+    }
+
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out << args;
+    socket.write(data);
+    if (!socket.waitForBytesWritten(CONNECT_TIMEOUT))
+    {
+        qWarning() << "转发参数失败：" << socket.errorString();
+        return false;
+    }
+    socket.disconnectFromServer();
+    lock.reset();
+    return true;
+}
+
+/**
+ * @brief SingleInstance::listen
+ * 在 sendToRunning() 连接失败之后调用：此时持有启动锁，确认没有实例在监听，
+ * 上一个实例崩溃后留下的套接字文件可以放心清掉；监听后释放锁
+ */
+bool SingleInstance::listen()
+{
+    server = new QLocalServer(this);
+    server->setSocketOptions(QLocalServer::UserAccessOption);
+    if (noServer && lock && lock->isLocked())
+        QLocalServer::removeServer(serverName);
+    const bool ok = server->listen(serverName);
+    lock.reset();
+    if (!ok)
+    {
+        qWarning() << "单实例监听失败：" << server->errorString();
+        return false;
+    }
+
+    connect(server, &QLocalServer::newConnection, this, [=]{
+        while (QLocalSocket* socket = server->nextPendingConnection())
+        {
+            connect(socket, &QLocalSocket::readyRead, this, &SingleInstance::readArguments);
+            connect(socket, &QLocalSocket::disconnected, socket, &QLocalSocket::deleteLater);
+        }
+    });
+    return true;
+}
+
+/**
+ * @brief SingleInstance::readArguments
+ * 参数可能分几次到达，读完整了再处理
+ */
+void SingleInstance::readArguments()
+{
+    QLocalSocket* socket = qobject_cast<QLocalSocket*>(sender());
+    QDataStream in(socket);
+    in.startTransaction();
+    QStringList args;
+    in >> args;
+    if (!in.commitTransaction())
+        return ;
+    emit argumentsReceived(args);
+}
@@ -0,0 +1,40 @@
+#ifndef SINGLEINSTANCE_H
+#define SINGLEINSTANCE_H
+
+#include <QObject>
+#include <QStringList>
+#include <QScopedPointer>
+
+class QLocalServer;
+class QLockFile;
+
+/**
+ * 单实例
+ * 第一个进程在本地套接字上监听；之后启动的进程把命令行参数转发给它后直接退出，
+ * 不必再初始化窗口、读取设置。
+ * 从尝试连接到开始监听之间持有锁文件，同时启动的两个进程不会互相抢占套接字
+ */
+class SingleInstance : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SingleInstance(QObject *parent = nullptr);
+    ~SingleInstance() override;
+
+    bool sendToRunning(const QStringList& args);
+    bool listen();
+
+signals:
+    void argumentsReceived(const QStringList& args);
+
+private:
+    void readArguments();
+
+private:
+    QString serverName;
+    QLocalServer* server = nullptr;
+    QScopedPointer<QLockFile> lock;
+    bool noServer = false; // 持锁期间连接失败，套接字文件无人监听
+};
+
+#endif // SINGLEINSTANCE_H
@@ -0,0 +1,47 @@
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextStream>
+#include <QDebug>
+#include "startuptrace.h"
+
+static bool enabled = false;
+static QElapsedTimer timer;
+static QString logPath;
+
+/**
+ * @brief StartupTrace::start
+ * 在 main() 的第一行调用，此后的阶段都以这里为起点
+ */
+void StartupTrace::start(int argc, char *argv[])
+{
+    const QByteArray env = qgetenv("NOTEPAD_TRACE_STARTUP");
+    enabled = !env.isEmpty();
+    if (enabled && env != "1")
+        logPath = QString::fromLocal8Bit(env);
+    for (int i = 1; i < argc; i++)
+        if (qstrcmp(argv[i], "--trace-startup") == 0)
+            enabled = true;
+    if (enabled)
+        timer.start();
+}
+
+bool StartupTrace::isEnabled()
+{
+    return enabled;
+}
+
+void StartupTrace::mark(const QString &phase)
+{
+    if (!enabled)
+        return ;
+
+    const QString line = QString("startup %1 ms: %2").arg(timer.nsecsElapsed() / 1e6, 0, 'f', 1).arg(phase);
+    if (logPath.isEmpty())
+    {
+        qInfo().noquote() << line;
+        return ;
+    }
+    QFile file(logPath);
+    if (file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text))
+        QTextStream(&file) << line << "\n";
+}
@@ -0,0 +1,20 @@
+#ifndef STARTUPTRACE_H
+#define STARTUPTRACE_H
+
+#include <QString>
+
+/**
+ * 启动耗时记录
+ * 设置环境变量 NOTEPAD_TRACE_STARTUP 或带上 --trace-startup 参数时，
+ * 记录从 main() 开始到各阶段（创建窗口、首次绘制、文件读完等）经过的毫秒数；
+ * 环境变量的值不是 1 时当作日志文件路径，否则输出到调试信息
+ */
+class StartupTrace
+{
+public:
+    static void start(int argc, char* argv[]);
+    static bool isEnabled();
+    static void mark(const QString& phase);
+};
+
+#endif // STARTUPTRACE_H
@@ -0,0 +1,66 @@
+QT       += core gui widgets concurrent network testlib
+
+CONFIG += c++11 testcase
+CONFIG -= app_bundle
+
+TARGET = tst_benchmark
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+# 直接编译程序本身的源文件（main.cpp 除外），测量的是实际的代码路径
+APP_DIR = $$PWD/../..
+INCLUDEPATH += $$APP_DIR
+
+SOURCES += \
+    tst_benchmark.cpp \
+    $$APP_DIR/batchprocessor.cpp \
+    $$APP_DIR/dirtytracker.cpp \
+    $$APP_DIR/documenttab.cpp \
+    $$APP_DIR/encodingdetector.cpp \
+    $$APP_DIR/fileloader.cpp \
+    $$APP_DIR/filemonitor.cpp \
+    $$APP_DIR/filesaver.cpp \
+    $$APP_DIR/finddialog.cpp \
+    $$APP_DIR/gotodialog.cpp \
+    $$APP_DIR/largefileview.cpp \
+    $$APP_DIR/layoutscheduler.cpp \
+    $$APP_DIR/lineending.cpp \
+    $$APP_DIR/lineindex.cpp \
+    $$APP_DIR/mainwindow.cpp \
+    $$APP_DIR/piecetable.cpp \
+    $$APP_DIR/searchengine.cpp \
+    $$APP_DIR/sessionjournal.cpp \
+    $$APP_DIR/settingscache.cpp \
+    $$APP_DIR/singleinstance.cpp \
+    $$APP_DIR/startuptrace.cpp \
+    $$APP_DIR/textbuffer.cpp \
+    $$APP_DIR/textmatcher.cpp
+
+HEADERS += \
+    $$APP_DIR/batchprocessor.h \
+    $$APP_DIR/dirtytracker.h \
+    $$APP_DIR/documenttab.h \
+    $$APP_DIR/encodingdetector.h \
+    $$APP_DIR/fileloader.h \
+    $$APP_DIR/filemonitor.h \
+    $$APP_DIR/filesaver.h \
+    $$APP_DIR/finddialog.h \
+    $$APP_DIR/gotodialog.h \
+    $$APP_DIR/largefileview.h \
+    $$APP_DIR/layoutscheduler.h \
+    $$APP_DIR/lineending.h \
+    $$APP_DIR/lineindex.h \
+    $$APP_DIR/mainwindow.h \
+    $$APP_DIR/piecetable.h \
+    $$APP_DIR/searchengine.h \
+    $$APP_DIR/sessionjournal.h \
+    $$APP_DIR/settingscache.h \
+    $$APP_DIR/singleinstance.h \
+    $$APP_DIR/startuptrace.h \
+    $$APP_DIR/textbuffer.h \
+    $$APP_DIR/textmatcher.h
+
+FORMS += \
+    $$APP_DIR/finddialog.ui \
+    $$APP_DIR/gotodialog.ui \
+    $$APP_DIR/mainwindow.ui
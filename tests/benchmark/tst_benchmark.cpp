@@ -0,0 +1,429 @@
+#include <QtTest>
+#include <QAction>
+#include <QLabel>
+#include <QLineEdit>
+#include <QCheckBox>
+#include <QPushButton>
+#include <QPlainTextEdit>
+#include <QTemporaryDir>
+#include <QTextCodec>
+#include <QTextBlock>
+#include <QScopedPointer>
+#include "mainwindow.h"
+#include "encodingdetector.h"
+#include "fileloader.h"
+#include "largefileview.h"
+#include "sessionjournal.h"
+
+static const qint64 MB = 1024 * 1024;
+static const qint64 LARGE_FILE_SIZE = 512 * MB; // 超过这个大小只读查看，与主窗口的默认值相同
+static const int LOAD_TIMEOUT = 10 * 60 * 1000; // 1 GB 的文件读完也够用
+static const int SAVE_TIMEOUT = 10 * 60 * 1000;
+static const char* const FIND_PATTERN = "狐狸";
+
+/**
+ * 不需要显示，默认使用 offscreen 平台；必须在 QTEST_MAIN 创建 QApplication 之前设置
+ */
+static void useOffscreenPlatform()
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+}
+Q_CONSTRUCTOR_FUNCTION(useOffscreenPlatform)
+
+/**
+ * 编辑器热点路径的性能测量
+ * 生成指定大小和编码的临时文件，在主窗口中经由菜单动作、查找对话框和按键测量
+ * 打开、输入、刷新光标位置、查找下一个（含环绕）、全部替换、保存的耗时，并检查结果。
+ * 大小和编码由环境变量指定，默认只测 1 MB：
+ *   NOTEPAD_BENCH_SIZES=1,100,1024 NOTEPAD_BENCH_ENCODINGS=UTF-8,GBK,UTF-16LE
+ * 机器可读的结果使用 QtTest 自带的输出格式，如 -o result.xml,xml 或 -o result.csv,csv
+ */
+class tst_Benchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void openFile_data();
+    void openFile();
+    void keystroke_data();
+    void keystroke();
+    void cursorPositionUpdate_data();
+    void cursorPositionUpdate();
+    void findNext_data();
+    void findNext();
+    void findNextWrap_data();
+    void findNextWrap();
+    void replaceAll_data();
+    void replaceAll();
+    void save_data();
+    void save();
+
+private:
+    struct GeneratedFile
+    {
+        QString path;
+        int length = 0;  // 解码后的字符数
+        int matches = 0; // FIND_PATTERN 出现的次数
+    };
+
+    void addFileRows();
+    bool generate(GeneratedFile* file);
+    bool openGenerated(MainWindow& window, GeneratedFile* file);
+    static bool waitLoaded(MainWindow& window, int length);
+    static QPlainTextEdit* editorOf(MainWindow& window);
+    static QAction* action(MainWindow& window, const char* name);
+    static void openFind(MainWindow& window, bool replace);
+
+private:
+    QTemporaryDir dir;
+    QList<int> sizes;
+    QList<QByteArray> codecs;
+};
+
+static QStringList listFromEnvironment(const char* name, const QString& defaultValue)
+{
+    QString value = qEnvironmentVariable(name);
+    if (value.isEmpty())
+        value = defaultValue;
+    QStringList list;
+    for (const QString& item: value.split(','))
+        if (!item.trimmed().isEmpty())
+            list << item.trimmed();
+    return list;
+}
+
+void tst_Benchmark::initTestCase()
+{
+    QVERIFY(dir.isValid());
+    for (const QString& s: listFromEnvironment("NOTEPAD_BENCH_SIZES", "1"))
+        sizes << s.toInt();
+    for (const QString& c: listFromEnvironment("NOTEPAD_BENCH_ENCODINGS", "UTF-8,GBK,UTF-16LE"))
+        codecs << c.toLatin1();
+
+    // 设置和恢复日志都不写到用户自己的目录
+    QStandardPaths::setTestModeEnabled(true);
+    QDir().mkpath(dir.filePath("recovery"));
+    SessionJournal::setDirectory(dir.filePath("recovery"));
+}
+
+void tst_Benchmark::addFileRows()
+{
+    QTest::addColumn<int>("sizeMB");
+    QTest::addColumn<QByteArray>("codec");
+    for (int size: sizes)
+        for (const QByteArray& codec: codecs)
+            if (size * MB < LARGE_FILE_SIZE || !codec.startsWith("UTF-16")) // 超大的 UTF-16 文件会拒绝打开
+                QTest::newRow(qPrintable(QString("%1MB-%2").arg(size).arg(QString(codec)))) << size << codec;
+}
+
+/**
+ * @brief tst_Benchmark::generate
+ * 中英文混排的行重复到指定大小，UTF-16 写入 BOM；顺带算出解码后的长度和匹配数
+ */
+bool tst_Benchmark::generate(GeneratedFile *file)
+{
+    QFETCH(int, sizeMB);
+    QFETCH(QByteArray, codec);
+    file->path = dir.filePath(QString("bench-%1-%2.txt").arg(sizeMB).arg(QString(codec)));
+
+    QTextCodec* textCodec = QTextCodec::codecForName(codec);
+    if (!textCodec)
+        return false;
+    QFile out(file->path);
+    if (!out.open(QIODevice::WriteOnly))
+        return false;
+
+    QScopedPointer<QTextEncoder> encoder(textCodec->makeEncoder(QTextCodec::IgnoreHeader));
+    if (codec.startsWith("UTF-16"))
+        out.write(EncodingDetector::byteOrderMark(codec));
+    QString block;
+    for (int i = 0; i < 1000; i++)
+        block += QString("%1 The quick brown fox jumps over the lazy dog. 敏捷的棕色狐狸跳过了懒狗。\n").arg(i);
+    const QByteArray bytes = encoder->fromUnicode(block);
+    file->length = file->matches = 0;
+    for (qint64 written = 0; written < qint64(sizeMB) * MB; written += bytes.size())
+    {
+        if (out.write(bytes) < 0)
+            return false;
+        file->length += block.length();
+        file->matches += 1000;
+    }
+    return true;
+}
+
+/**
+ * @brief tst_Benchmark::openGenerated
+ * 生成文件并在窗口中打开，等到全部载入
+ */
+bool tst_Benchmark::openGenerated(MainWindow &window, GeneratedFile *file)
+{
+    if (!generate(file))
+        return false;
+    window.openFile(file->path);
+    return waitLoaded(window, file->length);
+}
+
+/**
+ * @brief tst_Benchmark::waitLoaded
+ * 小文件打开时就已读完；大文件等后台分块全部追加、编辑器恢复可写；超大文件映射后即可查看
+ */
+bool tst_Benchmark::waitLoaded(MainWindow &window, int length)
+{
+    QPlainTextEdit* edit = editorOf(window);
+    LargeFileView* view = window.findChild<LargeFileView*>();
+    return QTest::qWaitFor([&]{
+        return view->isVisible()
+                || (!edit->isReadOnly() && edit->document()->characterCount() - 1 == length);
+    }, LOAD_TIMEOUT);
+}
+
+QPlainTextEdit *tst_Benchmark::editorOf(MainWindow &window)
+{
+    return window.findChild<QPlainTextEdit*>();
+}
+
+QAction *tst_Benchmark::action(MainWindow &window, const char *name)
+{
+    return window.findChild<QAction*>(name);
+}
+
+/**
+ * @brief tst_Benchmark::openFind
+ * 打开查找/替换对话框，填入关键词，开启循环查找
+ */
+void tst_Benchmark::openFind(MainWindow &window, bool replace)
+{
+    action(window, replace ? "actionReplace_R" : "actionFind_F")->trigger();
+    window.findChild<QLineEdit*>("findEdit")->setText(QString::fromUtf8(FIND_PATTERN));
+    window.findChild<QCheckBox*>("loopCheck")->setChecked(true);
+}
+
+void tst_Benchmark::openFile_data()
+{
+    addFileRows();
+}
+
+void tst_Benchmark::openFile()
+{
+    GeneratedFile file;
+    QVERIFY(generate(&file));
+    MainWindow window;
+    window.resize(1000, 700);
+    window.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&window));
+
+    QBENCHMARK_ONCE {
+        window.openFile(file.path);
+        QVERIFY2(waitLoaded(window, file.length), "文件没有读完");
+    }
+    QCOMPARE(window.isModified(), false);
+}
+
+void tst_Benchmark::keystroke_data()
+{
+    addFileRows();
+}
+
+/**
+ * @brief tst_Benchmark::keystroke
+ * 经过编辑器的按键处理，包括 textChanged 及跟随文档变化的片段表、查找索引、恢复日志等
+ */
+void tst_Benchmark::keystroke()
+{
+    MainWindow window;
+    window.show();
+    GeneratedFile file;
+    QVERIFY(openGenerated(window, &file));
+    QPlainTextEdit* edit = editorOf(window);
+    if (!edit->isVisible())
+        QSKIP("超大文件只读查看，不能输入");
+
+    edit->moveCursor(QTextCursor::Start);
+    int typed = 0;
+    QBENCHMARK {
+        QTest::keyClick(edit, 'a');
+        typed++;
+    }
+    QCOMPARE(edit->document()->characterCount() - 1, file.length + typed);
+    QVERIFY(window.isModified());
+}
+
+void tst_Benchmark::cursorPositionUpdate_data()
+{
+    addFileRows();
+}
+
+/**
+ * @brief tst_Benchmark::cursorPositionUpdate
+ * 每次跳到另一段；状态栏每帧最多刷新一次，最后检查显示的是最终位置
+ */
+void tst_Benchmark::cursorPositionUpdate()
+{
+    MainWindow window;
+    window.show();
+    GeneratedFile file;
+    QVERIFY(openGenerated(window, &file));
+    QPlainTextEdit* edit = editorOf(window);
+    if (!edit->isVisible())
+        QSKIP("超大文件只读查看，没有光标位置");
+
+    // 不自动换行时显示行号就是段落号
+    QAction* wrap = action(window, "actionWord_Wrap_W");
+    if (wrap->isChecked())
+        wrap->trigger();
+
+    QTextDocument* doc = edit->document();
+    const int blocks = doc->blockCount();
+    int moves = 0;
+    int block = 0;
+    QBENCHMARK {
+        block = static_cast<int>(qint64(++moves) * 7919 % blocks);
+        edit->setTextCursor(QTextCursor(doc->findBlockByNumber(block)));
+    }
+
+    const QString expected = QString("第 %1 行，第 1 列").arg(block + 1);
+    QVERIFY(QTest::qWaitFor([&]{
+        for (QLabel* label: window.findChildren<QLabel*>())
+            if (label->text() == expected)
+                return true;
+        return false;
+    }));
+}
+
+void tst_Benchmark::findNext_data()
+{
+    addFileRows();
+}
+
+/**
+ * @brief tst_Benchmark::findNext
+ * 从文档中间起连续“查找下一个”，包括选中、滚动和高亮；先等匹配索引建好
+ */
+void tst_Benchmark::findNext()
+{
+    MainWindow window;
+    window.show();
+    GeneratedFile file;
+    QVERIFY(openGenerated(window, &file));
+    QPlainTextEdit* edit = editorOf(window);
+    if (!edit->isVisible())
+        QSKIP("超大文件只读查看，只测打开");
+
+    openFind(window, false);
+    QTextCursor tc(edit->document());
+    tc.setPosition(file.length / 2);
+    edit->setTextCursor(tc);
+    QAction* findNext = action(window, "actionFind_Next_N");
+    findNext->trigger();
+    QLabel* count = window.findChild<QLabel*>("countLabel");
+    QTRY_VERIFY(count->text().endsWith(QString("共 %1 个").arg(file.matches)));
+
+    QBENCHMARK {
+        findNext->trigger();
+    }
+    QCOMPARE(edit->textCursor().selectedText(), QString::fromUtf8(FIND_PATTERN));
+}
+
+void tst_Benchmark::findNextWrap_data()
+{
+    addFileRows();
+}
+
+/**
+ * @brief tst_Benchmark::findNextWrap
+ * 光标在末尾，每次都要从开头重新找到第一个
+ */
+void tst_Benchmark::findNextWrap()
+{
+    MainWindow window;
+    window.show();
+    GeneratedFile file;
+    QVERIFY(openGenerated(window, &file));
+    QPlainTextEdit* edit = editorOf(window);
+    if (!edit->isVisible())
+        QSKIP("超大文件只读查看，只测打开");
+
+    openFind(window, false);
+    QAction* findNext = action(window, "actionFind_Next_N");
+    findNext->trigger();
+    QLabel* count = window.findChild<QLabel*>("countLabel");
+    QTRY_VERIFY(count->text().endsWith(QString("共 %1 个").arg(file.matches)));
+
+    QBENCHMARK {
+        edit->moveCursor(QTextCursor::End);
+        findNext->trigger();
+    }
+    QCOMPARE(edit->textCursor().selectedText(), QString::fromUtf8(FIND_PATTERN));
+    QCOMPARE(edit->textCursor().selectionStart(), edit->document()->find(QString::fromUtf8(FIND_PATTERN)).selectionStart());
+}
+
+void tst_Benchmark::replaceAll_data()
+{
+    addFileRows();
+}
+
+/**
+ * @brief tst_Benchmark::replaceAll
+ * 通过替换对话框全部替换，整体一步撤销
+ */
+void tst_Benchmark::replaceAll()
+{
+    MainWindow window;
+    window.show();
+    GeneratedFile file;
+    QVERIFY(openGenerated(window, &file));
+    QPlainTextEdit* edit = editorOf(window);
+    if (!edit->isVisible())
+        QSKIP("超大文件只读查看，不能替换");
+
+    openFind(window, true);
+    window.findChild<QLineEdit*>("replaceEdit")->setText("狐");
+    QPushButton* button = window.findChild<QPushButton*>("replaceAllButton");
+    QBENCHMARK_ONCE {
+        button->click();
+    }
+    QCOMPARE(edit->document()->characterCount() - 1, file.length - file.matches);
+    QVERIFY(edit->document()->find(QString::fromUtf8(FIND_PATTERN)).isNull());
+
+    edit->undo();
+    QCOMPARE(edit->document()->characterCount() - 1, file.length);
+}
+
+void tst_Benchmark::save_data()
+{
+    addFileRows();
+}
+
+/**
+ * @brief tst_Benchmark::save
+ * 取快照、后台编码写入直到修改标记清除，再读回比较
+ */
+void tst_Benchmark::save()
+{
+    MainWindow window;
+    window.show();
+    GeneratedFile file;
+    QVERIFY(openGenerated(window, &file));
+    QPlainTextEdit* edit = editorOf(window);
+    if (!edit->isVisible())
+        QSKIP("超大文件只读查看，不能保存");
+
+    edit->moveCursor(QTextCursor::Start);
+    QTest::keyClick(edit, 'a');
+    QVERIFY(window.isModified());
+    QBENCHMARK_ONCE {
+        action(window, "actionSave")->trigger();
+        QVERIFY2(QTest::qWaitFor([&]{ return !window.isModified(); }, SAVE_TIMEOUT), "保存没有完成");
+    }
+
+    FileLoader loader;
+    QVERIFY(loader.open(file.path));
+    QVERIFY(loader.readAll() == edit->toPlainText());
+}
+
+QTEST_MAIN(tst_Benchmark)
+
+#include "tst_benchmark.moc"
@@ -0,0 +1,136 @@
+#include <QTextDocument>
+#include <QTextCursor>
+#include <QDebug>
+#include "textbuffer.h"
+
+/**
+ * 文档把 \r\n 和单独的 \r 都当作一个段落分隔，片段表里统一存为 \n；
+ * 大多数文件没有 \r，原样共享不复制
+ */
+static QString normalized(const QString& text)
+{
+    if (!text.contains(QLatin1Char('\r')))
+        return text;
+    QString result = text;
+    result.replace(QLatin1String("\r\n"), QLatin1String("\n"));
+    result.replace(QLatin1Char('\r'), QLatin1Char('\n'));
+    return result;
+}
+
+TextBuffer::TextBuffer(QTextDocument *doc, QObject *parent)
+    : QObject(parent), doc(doc)
+{
+    connect(doc, &QTextDocument::contentsChange, this, &TextBuffer::onContentsChange);
+}
+
+/**
+ * @brief TextBuffer::text
+ * 当前内容的快照，之后的编辑不影响它，可以交给其他线程；
+ * 第一次调用时从文档建立片段表，之后一直跟随
+ */
+PieceTable TextBuffer::text()
+{
+    if (!active)
+        rebuild();
+    return table;
+}
+
+int TextBuffer::length() const
+{
+    return textLength;
+}
+
+/**
+ * @brief TextBuffer::setSuspended
+ * 暂停期间文档的变化不跟随，之后要用 reset()、append() 补上同样的内容
+ */
+void TextBuffer::setSuspended(bool suspended)
+{
+    this->suspended = suspended;
+}
+
+/**
+ * @brief TextBuffer::reset
+ * 片段表还没建立时只记长度，原文不保留
+ */
+void TextBuffer::reset(const QString &text)
+{
+    const int removed = textLength;
+    const QString normalizedText = normalized(text);
+    if (active)
+        table = PieceTable(normalizedText);
+    textLength = normalizedText.length();
+    emit contentsChange(0, removed, textLength);
+}
+
+void TextBuffer::append(const QString &text)
+{
+    const int position = textLength;
+    const QString normalizedText = normalized(text);
+    if (active)
+        table.append(normalizedText);
+    textLength += normalizedText.length();
+    emit contentsChange(position, 0, normalizedText.length());
+}
+
+/**
+ * @brief TextBuffer::release
+ * 暂时用不到时丢掉片段表，下次取文本时再建立；已取出的快照不受影响
+ */
+void TextBuffer::release()
+{
+    table = PieceTable();
+    active = false;
+}
+
+/**
+ * @brief TextBuffer::onContentsChange
+ * 只取新增的那一段文字；改动涉及文档末尾时 Qt 会多报一个字符，按实际长度截断
+ */
+void TextBuffer::onContentsChange(int position, int charsRemoved, int charsAdded)
+{
+    if (suspended || (!charsRemoved && !charsAdded))
+        return ;
+
+    const int length = doc->characterCount() - 1;
+    const int added = qMax(0, qMin(position + charsAdded, length) - position);
+    const int removed = charsRemoved - (charsAdded - added);
+    textLength = length;
+    if (active)
+    {
+        QString text;
+        if (added)
+        {
+            QTextCursor tc(doc);
+            tc.setPosition(position);
+            tc.setPosition(position + added, QTextCursor::KeepAnchor);
+            text = tc.selectedText();
+            text.replace(QChar::ParagraphSeparator, '\n');
+        }
+        table.remove(position, removed);
+        table.insert(position, text);
+
+        if (table.length() != length) // 不应出现，出现了就整体重新同步
+        {
+            qWarning() << "文档文本不同步，重新读取" << table.length() << length;
+            rebuild();
+        }
+    }
+    emit contentsChange(position, removed, added);
+}
+
+/**
+ * @brief TextBuffer::rebuild
+ * 从文档取出全文建立片段表；与增量同步一样用 selectedText()，
+ * 不用 toPlainText()，后者会把不间断空格换成普通空格
+ */
+void TextBuffer::rebuild()
+{
+    QTextCursor tc(doc);
+    tc.select(QTextCursor::Document);
+    QString text = tc.selectedText();
+    text.replace(QChar::ParagraphSeparator, '\n');
+    table = PieceTable(text);
+    textLength = table.length();
+    active = true;
+}
@@ -0,0 +1,47 @@
+#ifndef TEXTBUFFER_H
+#define TEXTBUFFER_H
+
+#include <QObject>
+#include "piecetable.h"
+
+class QTextDocument;
+
+/**
+ * 文档文本
+ * 与 QTextDocument 同步的片段表，保存、查找、统计从这里取文本：
+ * 取快照只复制片段列表，不必每次 toPlainText() 复制全文。
+ * 第一次取文本时才从文档建立，只打开查看、从不查找和保存的文档不多占一份内存。
+ * 整体替换或追加大段文字时暂停跟随，由调用方直接交给 reset()、append()，原文不复制
+ */
+class TextBuffer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit TextBuffer(QTextDocument* doc, QObject *parent = nullptr);
+
+    PieceTable text();
+    int length() const;
+    void setSuspended(bool suspended);
+    void reset(const QString& text);
+    void append(const QString& text);
+    void release();
+
+signals:
+    // 片段表更新之后发出，参数与 QTextDocument::contentsChange 相同
+    void contentsChange(int position, int charsRemoved, int charsAdded);
+
+private slots:
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
+
+private:
+    void rebuild();
+
+private:
+    QTextDocument* doc;
+    PieceTable table;
+    bool active = false;  // 片段表已建立并跟随文档
+    int textLength = 0;   // 片段表未建立时也记录长度
+    bool suspended = false;
+};
+
+#endif // TEXTBUFFER_H
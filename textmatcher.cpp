@@ -0,0 +1,129 @@
+#include "textmatcher.h"
+
+TextMatcher::TextMatcher()
+{
+}
+
+TextMatcher::TextMatcher(const QString &pattern, bool caseSensitive, bool wholeWord)
+    : text(pattern), caseSensitive(caseSensitive), wholeWord(wholeWord)
+{
+    const int m = pattern.length();
+    folded.resize(m);
+    for (int i = 0; i < m; i++)
+        folded[i] = caseSensitive ? pattern.at(i).unicode() : foldCase(pattern.at(i).unicode());
+
+    // 同一格取最小跳距，低 8 位相同的字符共用也不会跳过匹配
+    skip.fill(m, 256);
+    for (int i = 0; i < m - 1; i++)
+        skip[folded.at(i) & 0xFF] = m - 1 - i;
+}
+
+QString TextMatcher::pattern() const
+{
+    return text;
+}
+
+int TextMatcher::length() const
+{
+    return folded.size();
+}
+
+bool TextMatcher::isEmpty() const
+{
+    return folded.isEmpty();
+}
+
+/**
+ * @brief TextMatcher::indexIn
+ * @return 从 from 开始的第一个匹配（全字匹配时跳过不在单词边界上的），没有则 -1；
+ *         text 之外视为单词边界
+ */
+int TextMatcher::indexIn(const QChar *text, int length, int from) const
+{
+    for (int i = find(text, length, from); i >= 0; i = find(text, length, i + 1))
+    {
+        if (!wholeWord || isWholeWord(text, length, i, folded.size()))
+            return i;
+    }
+    return -1;
+}
+
+/**
+ * @brief TextMatcher::matchesAt
+ * position 处正好是一个匹配（用于判断选中的文本）
+ */
+bool TextMatcher::matchesAt(const QChar *text, int length, int position) const
+{
+    const int m = folded.size();
+    if (m == 0 || position < 0 || position + m > length)
+        return false;
+    if (!equalsAt(reinterpret_cast<const ushort*>(text), position))
+        return false;
+    return !wholeWord || isWholeWord(text, length, position, m);
+}
+
+bool TextMatcher::isWordChar(QChar c)
+{
+    return c.isLetterOrNumber() || c == '_';
+}
+
+/**
+ * @brief TextMatcher::isWholeWord
+ * 匹配的前后都不是单词字符（文本两端视为边界）
+ */
+bool TextMatcher::isWholeWord(const QChar *text, int length, int position, int matchLength)
+{
+    if (position > 0 && isWordChar(text[position - 1]))
+        return false;
+    const int end = position + matchLength;
+    return end >= length || !isWordChar(text[end]);
+}
+
+/**
+ * @brief TextMatcher::find
+ * Boyer-Moore-Horspool，不考虑单词边界
+ */
+int TextMatcher::find(const QChar *text, int length, int from) const
+{
+    const int m = folded.size();
+    if (m == 0 || from < 0 || length - from < m)
+        return -1;
+
+    const ushort* t = reinterpret_cast<const ushort*>(text);
+    const ushort* p = folded.constData();
+    if (m == 1)
+    {
+        for (int i = from; i < length; i++)
+            if ((caseSensitive ? t[i] : foldCase(t[i])) == p[0])
+                return i;
+        return -1;
+    }
+
+    const int* s = skip.constData();
+    const ushort last = p[m - 1];
+    for (int i = from; i <= length - m; )
+    {
+        const ushort c = caseSensitive ? t[i + m - 1] : foldCase(t[i + m - 1]);
+        if (c == last && equalsAt(t, i))
+            return i;
+        i += s[c & 0xFF];
+    }
+    return -1;
+}
+
+bool TextMatcher::equalsAt(const ushort *text, int position) const
+{
+    const ushort* p = folded.constData();
+    const int m = folded.size();
+    if (caseSensitive)
+    {
+        for (int j = m - 1; j >= 0; j--)
+            if (text[position + j] != p[j])
+                return false;
+        return true;
+    }
+    for (int j = m - 1; j >= 0; j--)
+        if (foldCase(text[position + j]) != p[j])
+            return false;
+    return true;
+}
@@ -0,0 +1,48 @@
+#ifndef TEXTMATCHER_H
+#define TEXTMATCHER_H
+
+#include <QString>
+#include <QVector>
+
+/**
+ * 普通文本匹配
+ * 构造时把关键词做好大小写折叠并建立 Boyer-Moore-Horspool 跳转表，
+ * 之后在任意 QChar 区间上查找、比较都不再分配内存。
+ * 不区分大小写时使用 Unicode 简单大小写折叠（ASCII 走快速路径）
+ */
+class TextMatcher
+{
+public:
+    TextMatcher();
+    TextMatcher(const QString& pattern, bool caseSensitive, bool wholeWord = false);
+
+    QString pattern() const;
+    int length() const;
+    bool isEmpty() const;
+
+    int indexIn(const QChar* text, int length, int from = 0) const;
+    bool matchesAt(const QChar* text, int length, int position) const;
+
+    static bool isWordChar(QChar c);
+    static bool isWholeWord(const QChar* text, int length, int position, int matchLength);
+
+private:
+    int find(const QChar* text, int length, int from) const;
+    bool equalsAt(const ushort* text, int position) const;
+
+    static inline ushort foldCase(ushort c)
+    {
+        if (c < 0x80)
+            return (c >= 'A' && c <= 'Z') ? static_cast<ushort>(c + ('a' - 'A')) : c;
+        return static_cast<ushort>(QChar::toCaseFolded(static_cast<uint>(c)));
+    }
+
+private:
+    QString text;
+    bool caseSensitive = true;
+    bool wholeWord = false;
+    QVector<ushort> folded; // 折叠后的关键词
+    QVector<int> skip;      // 按字符低 8 位索引的跳距
+};
+
+#endif // TEXTMATCHER_H